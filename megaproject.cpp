@@ -20,7 +20,34 @@
 #include <string>
 #include <cmath>
 #include <cstdint> // For uint8_t (0-255 standard pixel range)
+#include <climits> // INT_MAX (header value range checks)
+#include <cctype>
+#include <cstring>
 #include <iomanip>
+#include <chrono>    // Benchmark timing
+#include <thread>    // Parallel parsing workers
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <mutex>     // Debug writer thread synchronisation
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <cstdlib>   // getenv (runtime configuration)
+#include <cstdio>    // sscanf (--roi parsing)
+#include <atomic>
+#include <filesystem> // Batch directory scanning
+#include <new>       // Aligned allocation (planar frames)
+#include <memory>    // unique_ptr (buffer ownership)
+#include <sys/mman.h>  // mmap (Zero-copy file mapping)
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h> // Raw io_uring system calls
+#include <sys/uio.h>
+#include <sched.h>           // Thread affinity (NUMA worker placement)
+#include <linux/mempolicy.h> // mbind policies
+#include <linux/io_uring.h>
 
 // --- HARDWARE EMULATION SETTINGS ---
 #define FIXED_POINT_MODE // Enable integer-only math (Hardware optimization)
@@ -32,16 +59,36 @@ using namespace std;
 // MODULE 1: LOGGER (System Monitor)
 // ============================================================
 class Logger {
+    // Background threads log too; one line is written at a time
+    static inline mutex outputLock;
+
 public:
+    // Silences status logs (used by benchmark runs); errors still go to cerr
+    static inline bool quiet = false;
+
+    // Status destination; pipe mode moves it to cerr so stdout carries frames only
+    static inline ostream* stream = &cout;
+
     // General system logs
     static void log(string module, string message) {
-        cout << left << setw(12) << "[" + module + "]" << " : " << message << endl;
+        if (quiet) return;
+        lock_guard<mutex> guard(outputLock);
+        *stream << left << setw(12) << "[" + module + "]" << " : " << message << endl;
     }
     
+    // Section divider in the execution trace
+    static void separator() {
+        if (quiet) return;
+        lock_guard<mutex> guard(outputLock);
+        *stream << "------------------------------------------------" << endl;
+    }
+
     // Hardware register/memory logs
     static void hardwareLog(string msg) {
         #ifdef DEBUG_MODE
-        cout << "   >> [HW_REG] " << msg << endl;
+        if (quiet) return;
+        lock_guard<mutex> guard(outputLock);
+        *stream << "   >> [HW_REG] " << msg << endl;
         #endif
     }
 };
@@ -74,32 +121,327 @@ namespace HardwareMath {
 struct Pixel {
     uint8_t r, g, b; // Red, Green, Blue channels
 };
+// Binary PPM (P6) stores pixels as packed RGB triplets, exactly like our memory block.
+// This lets the loader burst-transfer the payload straight into the buffer.
+static_assert(sizeof(Pixel) == 3, "Pixel must be tightly packed RGB (3 bytes)");
+
+// NUMA topology on raw system calls (no libnuma dependency). Machines without
+// NUMA support look like a single node 0.
+namespace Numa {
+    // Number of memory nodes (at least 1)
+    inline int nodeCount() {
+        static const int count = [] {
+            int n = 0;
+            error_code ec;
+            while (filesystem::exists("/sys/devices/system/node/node" + to_string(n), ec)) n++;
+            return max(n, 1);
+        }();
+        return count;
+    }
+
+    // Node of the CPU the calling thread is running on
+    inline int currentNode() {
+        unsigned cpu = 0, node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+        return (int)node;
+    }
+
+    // Places the pages of [addr, addr + length) on 'node' when they are first touched
+    inline bool bindMemory(void* addr, size_t length, int node) {
+        unsigned long mask = 0;
+        if (node < 0 || node >= (int)(sizeof(mask) * 8)) return false;
+        mask = 1ul << node;
+        // maxnode counts one past the last mask bit
+        return syscall(SYS_mbind, addr, length, MPOL_PREFERRED, &mask, sizeof(mask) * 8 + 1, 0) == 0;
+    }
+
+    // Restricts the calling thread to the CPUs of 'node' (cpulist such as "0-3,8-11")
+    inline bool bindThread(int node) {
+        ifstream file("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+        string list;
+        if (!getline(file, list)) return false;
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        size_t pos = 0;
+        while (pos < list.size()) {
+            size_t end = list.find(',', pos);
+            if (end == string::npos) end = list.size();
+            int first, last;
+            int fields = sscanf(list.c_str() + pos, "%d-%d", &first, &last);
+            if (fields == 1) last = first;
+            if (fields >= 1) {
+                for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &cpus);
+            }
+            pos = end + 1;
+        }
+        return CPU_COUNT(&cpus) > 0 && sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+    }
+}
+
+// How large frame blocks are backed.
+// Transparent: madvise(MADV_HUGEPAGE) on 2 MB-aligned blocks (kernel THP);
+// Explicit: MAP_HUGETLB from the reserved pool (vm.nr_hugepages), else Transparent.
+enum class HugePageMode { Off, Transparent, Explicit };
+
+// [DMA SIMULATION] Frame memory region. Every frame buffer (Image, GrayImage) is
+// carved from this pool. A freed block goes onto the free list of its size class
+// instead of back to the heap, so processing a stream of same-sized frames (video,
+// batches) stops allocating after the first few frames. Blocks are 64-byte aligned.
+//
+// Blocks of LARGE_BLOCK bytes or more (wide frames) are mapped separately on 2 MB
+// boundaries so they can sit on huge pages: the 3x3 stencils touch three rows that
+// are a whole stride apart, and with 4 KB pages every row of an 8K frame is a
+// different TLB entry. With NUMA-local mode each node has its own free lists and
+// large blocks are bound to the node of the thread that requested them.
+//
+// Frame sizes vary (batches of mixed images), so a large request is served by the
+// smallest free block of up to twice its size class, and free large blocks are
+// kept only up to the peak in-use size: beyond that the smallest are unmapped.
+class FramePool {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t HUGE_PAGE = 2u << 20;
+    static constexpr size_t LARGE_BLOCK = HUGE_PAGE;
+
+    struct Stats {
+        size_t inUse = 0;          // Bytes handed out right now
+        size_t peak = 0;           // Highest 'inUse' so far
+        size_t reserved = 0;       // Bytes taken from the system (in use + free lists)
+        long long allocations = 0; // Blocks taken from the system
+        long long hugeBlocks = 0;  // ... of which are backed by huge pages
+        long long reuses = 0;      // Requests served from a free list
+        long long unmapped = 0;    // Free large blocks returned to the system
+    };
+
+    // Process-wide region. Never destroyed, so frames released during static
+    // destruction still find their pool.
+    static FramePool& global() {
+        static FramePool* pool = new FramePool();
+        return *pool;
+    }
+
+    // Set once at startup, before the first frame is allocated
+    void configure(HugePageMode mode, bool nodeLocal) {
+        lock_guard<mutex> lock(mtx);
+        hugePages = mode;
+        numaLocal = nodeLocal && Numa::nodeCount() > 1;
+    }
+
+    bool isNumaLocal() const { return numaLocal; }
+
+    // Block of at least 'bytes' (nullptr for 0 bytes)
+    void* acquire(size_t bytes) {
+        if (bytes == 0) return nullptr;
+        size_t size = sizeClass(bytes);
+        int node = numaLocal ? Numa::currentNode() : 0;
+        lock_guard<mutex> lock(mtx);
+        void* block = (size >= LARGE_BLOCK) ? reuseLarge(size, node) : nullptr;
+        vector<void*>& freeList = freeLists[{node, size}];
+        if (block) {
+            size = largeSizes[block];
+            stats.reuses++;
+        } else if (!freeList.empty()) {
+            block = freeList.back();
+            freeList.pop_back();
+            stats.reuses++;
+        } else {
+            if (size >= LARGE_BLOCK) {
+                block = mapLarge(size, node);
+                largeSizes[block] = size;
+            } else {
+                block = ::operator new(size, align_val_t(ALIGNMENT));
+            }
+            if (numaLocal) blockNodes[block] = node;
+            stats.reserved += size;
+            stats.allocations++;
+        }
+        stats.inUse += size;
+        stats.peak = max(stats.peak, stats.inUse);
+        return block;
+    }
+
+    // Returns a block obtained with acquire(bytes), with the same 'bytes'.
+    // The block goes back to the free list of the node its memory lives on.
+    void release(void* block, size_t bytes) {
+        if (!block) return;
+        size_t size = sizeClass(bytes);
+        lock_guard<mutex> lock(mtx);
+        int node = numaLocal ? blockNodes[block] : 0;
+        if (size >= LARGE_BLOCK) {
+            size = largeSizes[block]; // May be larger than requested (reuseLarge)
+            freeLarge += size;
+        }
+        freeLists[{node, size}].push_back(block);
+        stats.inUse -= size;
+        trimLarge();
+    }
+
+    Stats getStats() {
+        lock_guard<mutex> lock(mtx);
+        return stats;
+    }
+
+    // One status line, e.g. at the end of a run
+    void report(ostream& out) {
+        Stats s = getStats();
+        out << fixed << setprecision(1) << right;
+        out << "[DMA_POOL]   : peak " << s.peak / 1048576.0 << " MB in use, " << s.reserved / 1048576.0
+            << " MB reserved, " << s.allocations << " allocations (" << s.hugeBlocks << " on huge pages), "
+            << s.reuses << " reuses, " << s.unmapped << " unmapped" << (numaLocal ? ", NUMA-local" : "") << endl;
+    }
+
+    // Size classes: 4 steps per power of two (at most 25% slack), 4 KiB minimum.
+    // Large blocks are further rounded up to whole huge pages.
+    static size_t sizeClass(size_t bytes) {
+        size_t size = 4096;
+        if (bytes <= size) return size;
+        while (size * 2 < bytes) size *= 2;
+        size_t step = size / 4;
+        size_t cls = (bytes + step - 1) / step * step;
+        if (cls >= LARGE_BLOCK) cls = (cls + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+        return cls;
+    }
+
+private:
+    mutex mtx;
+    map<pair<int, size_t>, vector<void*>> freeLists; // (node, size class) -> free blocks
+    map<void*, int> blockNodes;                      // NUMA-local mode: node of every block
+    map<void*, size_t> largeSizes;                   // Mapped size of every large block
+    size_t freeLarge = 0;                            // Bytes of large blocks on the free lists
+    Stats stats;
+    HugePageMode hugePages = HugePageMode::Transparent;
+    bool numaLocal = false;
+    bool warnedHugeTlb = false, warnedBind = false;
+
+    // Smallest free large block of 'size' to 2 * 'size' bytes on 'node', or nullptr
+    // (called with the lock held)
+    void* reuseLarge(size_t size, int node) {
+        for (auto it = freeLists.lower_bound({node, size});
+             it != freeLists.end() && it->first.first == node && it->first.second <= 2 * size; ++it) {
+            if (it->second.empty()) continue;
+            void* block = it->second.back();
+            it->second.pop_back();
+            freeLarge -= it->first.second;
+            return block;
+        }
+        return nullptr;
+    }
+
+    // Unmaps the smallest free large blocks while more than the peak in-use size
+    // sits idle (called with the lock held)
+    void trimLarge() {
+        for (auto it = freeLists.begin(); freeLarge > stats.peak && it != freeLists.end(); ++it) {
+            size_t size = it->first.second;
+            if (size < LARGE_BLOCK) continue;
+            while (!it->second.empty() && freeLarge > stats.peak) {
+                void* block = it->second.back();
+                it->second.pop_back();
+                munmap(block, size);
+                largeSizes.erase(block);
+                blockNodes.erase(block);
+                freeLarge -= size;
+                stats.reserved -= size;
+                stats.unmapped++;
+            }
+        }
+    }
+
+    // Large block on its own mapping, 2 MB aligned (called with the lock held)
+    void* mapLarge(size_t size, int node) {
+        void* block = MAP_FAILED;
+        if (hugePages == HugePageMode::Explicit) {
+            block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (block != MAP_FAILED) {
+                stats.hugeBlocks++;
+            } else if (!warnedHugeTlb) {
+                warnedHugeTlb = true;
+                Logger::log("DMA_POOL", "No reserved huge pages (vm.nr_hugepages); using transparent huge pages");
+            }
+        }
+        if (block == MAP_FAILED) {
+            // Over-map by one huge page and trim both ends to a 2 MB boundary
+            size_t span = size + HUGE_PAGE;
+            void* raw = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) throw bad_alloc();
+            uintptr_t start = ((uintptr_t)raw + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+            size_t head = start - (uintptr_t)raw;
+            if (head > 0) munmap(raw, head);
+            if (span - head > size) munmap((void*)(start + size), span - head - size);
+            block = (void*)start;
+            if (hugePages != HugePageMode::Off && madvise(block, size, MADV_HUGEPAGE) == 0) stats.hugeBlocks++;
+        }
+        if (numaLocal && !Numa::bindMemory(block, size, node) && !warnedBind) {
+            warnedBind = true;
+            Logger::log("DMA_POOL", "mbind() failed; frame memory follows the first-touch policy");
+        }
+        return block;
+    }
+};
 
 class Image {
 private:
     int width, height;
     Pixel* data; // Raw pointer to simulate a hardware memory block
 
+    // Memory-mapped mode: 'data' points into a read-only file mapping
+    void* mapBase = nullptr;
+    size_t mapLength = 0;
+
 public:
     Image(int w, int h) : width(w), height(h) {
-        // [DMA SIMULATION] Manually allocating memory buffer
-        data = new Pixel[width * height]; 
+        // [DMA SIMULATION] Taking a memory block from the frame pool
+        data = static_cast<Pixel*>(FramePool::global().acquire(bytes()));
+    }
+
+    // Zero-copy constructor: wraps a read-only mapped payload (no allocation, no copy).
+    // The image takes ownership of the mapping and unmaps it on destruction.
+    Image(int w, int h, const Pixel* payload, void* base, size_t length)
+        : width(w), height(h), data(const_cast<Pixel*>(payload)), mapBase(base), mapLength(length) {}
+
+    // Frames own their memory block and are move-only: a copy is always an explicit clone()
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
+
+    // Move: the block changes owner; 'other' is left empty (0x0, no memory)
+    Image(Image&& other) noexcept
+        : width(other.width), height(other.height), data(other.data),
+          mapBase(other.mapBase), mapLength(other.mapLength) {
+        other.detach();
+    }
+
+    Image& operator=(Image&& other) noexcept {
+        if (this != &other) {
+            release();
+            width = other.width;
+            height = other.height;
+            data = other.data;
+            mapBase = other.mapBase;
+            mapLength = other.mapLength;
+            other.detach();
+        }
+        return *this;
     }
 
-    // Copy Constructor (Deep Copy for double buffering)
-    Image(const Image& other) : width(other.width), height(other.height) {
-        data = new Pixel[width * height];
-        for(int i=0; i<width*height; i++) data[i] = other.data[i];
+    // Deep copy into new writable memory (also for mapped frames)
+    Image clone() const {
+        Image copy(width, height);
+        memcpy(copy.data, data, (size_t)width * height * sizeof(Pixel));
+        return copy;
     }
 
     // Destructor (Memory Cleanup)
-    ~Image() {
-        if (data) delete[] data;
-    }
+    ~Image() { release(); }
+
+    // Mapped images live in read-only pages and must never be written
+    bool isReadOnly() const { return mapBase != nullptr; }
 
     int getWidth() const { return width; }
     int getHeight() const { return height; }
 
+    // Raw access to the memory block (used for burst DMA transfers)
+    Pixel* getData() { return data; }
+    const Pixel* getData() const { return data; }
+
     // Read from memory address
     Pixel getPixel(int x, int y) const {
         // Boundary Check (Zero Padding for edges)
@@ -111,270 +453,3975 @@ public:
 
     // Write to memory address
     void setPixel(int x, int y, Pixel p) {
-        if (x >= 0 && x < width && y >= 0 && y < height) {
+        if (!mapBase && x >= 0 && x < width && y >= 0 && y < height) {
             data[y * width + x] = p;
         }
     }
+
+private:
+    size_t bytes() const { return (size_t)width * height * sizeof(Pixel); }
+
+    void release() {
+        if (mapBase) munmap(mapBase, mapLength);
+        else FramePool::global().release(data, bytes());
+    }
+
+    void detach() {
+        width = height = 0;
+        data = nullptr;
+        mapBase = nullptr;
+        mapLength = 0;
+    }
 };
 
-// ============================================================
-// MODULE 4: FILE I/O (Disk Operations)
-// ============================================================
-class IOHandler {
+// Non-owning window onto packed RGB pixels: a whole frame, or a region of interest
+// inside one. Rows are 'stride' pixels apart, so a sub-region is only a pointer
+// offset into its parent frame; nothing is copied. Filters treat the edges of the
+// view as the frame edges (zero padding outside it, like Image::getPixel).
+// The viewed frame must outlive the view.
+class ImageView {
+private:
+    Pixel* data;
+    int width, height;
+    size_t stride;         // Pixels from one row to the next
+    bool readOnly = false; // Window onto a mapped frame
+
 public:
-    // Helper function to skip comments (lines starting with #) in PPM files
-    static void ignoreComments(ifstream& file) {
-        while (file >> ws && file.peek() == '#') {
-            file.ignore(4096, '\n'); // Skip the entire comment line
-        }
-    }
+    ImageView() : data(nullptr), width(0), height(0), stride(0) {}
 
-    static Image* loadPPM(const string& filename) {
-        Logger::log("DMA_READ", "Loading file: " + filename);
-        ifstream file(filename);
-        
-        if (!file) {
-            cerr << "[ERROR] File not found!" << endl;
-            return nullptr;
-        }
+    ImageView(Pixel* pixels, int w, int h, size_t rowStride)
+        : data(pixels), width(w), height(h), stride(rowStride) {}
 
-        string format;
-        int w, h, maxVal;
+    // Whole frame. Implicit, so an Image* can be passed wherever a view is expected.
+    ImageView(const Image* img)
+        : data(const_cast<Pixel*>(img->getData())), width(img->getWidth()), height(img->getHeight()),
+          stride(img->getWidth()), readOnly(img->isReadOnly()) {}
 
-        // Read PPM Header
-        file >> format;
-        if (format != "P3") {
-            cerr << "[ERROR] Invalid Format. Please use PPM P3 (ASCII)." << endl;
-            return nullptr;
-        }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t getStride() const { return stride; }
+    bool isReadOnly() const { return readOnly; }
 
-        ignoreComments(file); file >> w;
-        ignoreComments(file); file >> h;
-        ignoreComments(file); file >> maxVal;
+    Pixel* row(int y) { return data + (size_t)y * stride; }
+    const Pixel* row(int y) const { return data + (size_t)y * stride; }
 
-        Logger::hardwareLog("Resolution detected: " + to_string(w) + "x" + to_string(h));
-        
-        Image* img = new Image(w, h);
-        int r, g, b;
-        
-        // Load Pixel Data into RAM
-        for (int y = 0; y < h; y++) {
-            for (int x = 0; x < w; x++) {
-                file >> r >> g >> b;
-                img->setPixel(x, y, {(uint8_t)r, (uint8_t)g, (uint8_t)b});
-            }
-        }
-        return img;
+    // Same zero padding as Image::getPixel, at the edges of the view
+    Pixel getPixel(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return {0,0,0};
+        return data[(size_t)y * stride + x];
     }
 
-    static void savePPM(const Image* img, const string& filename) {
-        ofstream file(filename);
-        // Write Header (P3 format)
-        file << "P3\n" << img->getWidth() << " " << img->getHeight() << "\n255\n";
-        
-        // Write Pixel Data
-        for (int y = 0; y < img->getHeight(); y++) {
-            for (int x = 0; x < img->getWidth(); x++) {
-                Pixel p = img->getPixel(x, y);
-                file << (int)p.r << " " << (int)p.g << " " << (int)p.b << " ";
-            }
-            file << "\n";
+    void setPixel(int x, int y, Pixel p) {
+        if (!readOnly && x >= 0 && x < width && y >= 0 && y < height) {
+            data[(size_t)y * stride + x] = p;
         }
-        file.close();
+    }
+
+    // Sub-view of w x h pixels at (x, y), clipped to this view
+    ImageView region(int x, int y, int w, int h) const {
+        int x0 = min(max(x, 0), width), y0 = min(max(y, 0), height);
+        int x1 = min(max(x + w, x0), width), y1 = min(max(y + h, y0), height);
+        ImageView sub(const_cast<Pixel*>(row(y0)) + x0, x1 - x0, y1 - y0, stride);
+        sub.readOnly = readOnly;
+        return sub;
+    }
+
+    // Row-by-row copy into 'dest' (the overlapping top-left part if the sizes differ)
+    void copyTo(ImageView dest) const {
+        int w = min(width, dest.width), h = min(height, dest.height);
+        for (int y = 0; y < h; y++) memcpy(dest.row(y), row(y), (size_t)w * sizeof(Pixel));
+    }
+
+    // Deep copy into a new contiguous frame
+    Image clone() const {
+        Image copy(width, height);
+        copyTo(&copy);
+        return copy;
     }
 };
 
-// ============================================================
-// MODULE 5: FILTERS (Processing Cores)
-// ============================================================
+// How the halo (the ring of samples around a padded frame) is filled.
+// Zero matches Image::getPixel; Replicate repeats the edge sample; Reflect mirrors
+// around it without repeating it (x = -1 reads x = 1).
+enum class BorderMode { Zero, Replicate, Reflect };
 
-// Base Class (Polymorphism)
-class Filter {
+// Single-channel 8-bit frame (Gray8). After the grayscale converter every stage
+// carries intensity only, so one byte per pixel replaces three identical RGB bytes.
+//
+// Rows start on 64-byte boundaries, 'stride' bytes apart, and are surrounded by a
+// halo of HALO samples. A 3x3 kernel can read row(y - 1)[x - 1] anywhere in the
+// frame without bounds checks; the halo supplies the padding.
+class GrayImage {
 public:
-    virtual string getName() = 0;
-    virtual void apply(Image* src, Image* dest) = 0; // Pure Virtual Function
-    virtual ~Filter() {}
-};
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr int HALO = 1; // Enough for 3x3 kernels
+    static_assert(ALIGNMENT <= FramePool::ALIGNMENT, "Pool blocks must satisfy the row alignment");
+
+private:
+    int width, height;
+    size_t stride;    // Bytes from one row to the next
+    uint8_t* storage; // Pool block: HALO rows above, 'height' rows, HALO rows below
+    uint8_t* origin;  // Pixel (0, 0); the left halo sits just before it
+
+    size_t blockSize() const { return stride * ((size_t)height + 2 * HALO); }
 
-// --- STAGE 1: GRAYSCALE CONVERTER ---
-class GrayscaleFilter : public Filter {
 public:
-    string getName() override { return "Grayscale Converter"; }
-    
-    void apply(Image* src, Image* dest) override {
-        for (int y = 0; y < src->getHeight(); y++) {
-            for (int x = 0; x < src->getWidth(); x++) {
-                Pixel p = src->getPixel(x, y);
-                // Standard Formula: 0.3R + 0.59G + 0.11B
-                // Hardware Optimization: Using integer multiplication and bit shift
-                int gray = (p.r * 77 + p.g * 150 + p.b * 29) >> 8; 
-                uint8_t val = HardwareMath::clamp(gray);
-                dest->setPixel(x, y, {val, val, val});
-            }
+    // The halo starts zero-filled
+    GrayImage(int w, int h) : width(w), height(h) {
+        size_t needed = ALIGNMENT + (size_t)w + HALO; // Left pad keeps x = 0 aligned
+        stride = (needed + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        storage = static_cast<uint8_t*>(FramePool::global().acquire(blockSize()));
+        origin = storage + stride * HALO + ALIGNMENT;
+        fillHalo(BorderMode::Zero);
+    }
+
+    GrayImage(const GrayImage&) = delete;
+    GrayImage& operator=(const GrayImage&) = delete;
+
+    GrayImage(GrayImage&& other) noexcept
+        : width(other.width), height(other.height), stride(other.stride),
+          storage(other.storage), origin(other.origin) {
+        other.storage = other.origin = nullptr;
+        other.width = other.height = 0;
+    }
+
+    GrayImage& operator=(GrayImage&& other) noexcept {
+        if (this != &other) {
+            FramePool::global().release(storage, blockSize());
+            width = other.width;
+            height = other.height;
+            stride = other.stride;
+            storage = other.storage;
+            origin = other.origin;
+            other.storage = other.origin = nullptr;
+            other.width = other.height = 0;
         }
+        return *this;
     }
-};
 
-// --- STAGE 2: GAUSSIAN BLUR (3x3) ---
-class BlurFilter : public Filter {
-public:
-    string getName() override { return "Gaussian Blur (3x3)"; }
-    
-    void apply(Image* src, Image* dest) override {
-        // Gaussian Kernel for smoothing
-        int kernel[3][3] = {{1,2,1}, {2,4,2}, {1,2,1}}; 
-        int divisor = 16; 
-
-        for (int y = 0; y < src->getHeight(); y++) {
-            for (int x = 0; x < src->getWidth(); x++) {
-                int sum = 0;
-                // Convolution Loop
-                for (int ky = -1; ky <= 1; ky++) {
-                    for (int kx = -1; kx <= 1; kx++) {
-                        Pixel p = src->getPixel(x + kx, y + ky);
-                        sum += p.r * kernel[ky+1][kx+1]; // Using Red channel as intensity
-                    }
-                }
-                uint8_t val = HardwareMath::clamp(sum / divisor);
-                dest->setPixel(x, y, {val, val, val});
+    ~GrayImage() { FramePool::global().release(storage, blockSize()); }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t getStride() const { return stride; }
+
+    // Start of row y (valid for -HALO <= y < height + HALO; x from -HALO to width + HALO - 1)
+    uint8_t* row(int y) { return origin + (ptrdiff_t)y * (ptrdiff_t)stride; }
+    const uint8_t* row(int y) const { return origin + (ptrdiff_t)y * (ptrdiff_t)stride; }
+
+    // Same zero padding as Image::getPixel
+    uint8_t getPixel(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return 0;
+        return row(y)[x];
+    }
+
+    void setPixel(int x, int y, uint8_t v) {
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            row(y)[x] = v;
+        }
+    }
+
+    // Expands to {v,v,v} pixels (pipeline boundary, debug dumps)
+    void toInterleaved(Image* img) const {
+        for (int y = 0; y < height; y++) {
+            const uint8_t* gray = row(y);
+            Pixel* px = img->getData() + (size_t)y * width;
+            for (int x = 0; x < width; x++) px[x] = {gray[x], gray[x], gray[x]};
+        }
+    }
+
+    // Rewrites the halo from the current interior (O(perimeter)).
+    // Kernels never write the halo, so a zero halo stays valid once filled.
+    void fillHalo(BorderMode mode) {
+        // Source index for a coordinate outside 0..n-1
+        auto source = [mode](int i, int n) {
+            if (mode == BorderMode::Replicate || n == 1) return i < 0 ? 0 : n - 1;
+            int m = i < 0 ? -i : 2 * (n - 1) - i; // Reflect
+            return min(max(m, 0), n - 1);
+        };
+        for (int y = 0; y < height; y++) {
+            uint8_t* r = row(y);
+            for (int k = 1; k <= HALO; k++) {
+                r[-k] = (mode == BorderMode::Zero) ? 0 : r[source(-k, width)];
+                r[width - 1 + k] = (mode == BorderMode::Zero) ? 0 : r[source(width - 1 + k, width)];
+            }
+        }
+        for (int k = 1; k <= HALO; k++) {
+            // Whole halo rows, corners included
+            uint8_t* top = row(-k) - HALO;
+            uint8_t* bottom = row(height - 1 + k) - HALO;
+            size_t span = (size_t)width + 2 * HALO;
+            if (mode == BorderMode::Zero) {
+                memset(top, 0, span);
+                memset(bottom, 0, span);
+            } else {
+                memcpy(top, row(source(-k, height)) - HALO, span);
+                memcpy(bottom, row(source(height - 1 + k, height)) - HALO, span);
             }
         }
     }
 };
 
-// --- STAGE 3: SOBEL EDGE DETECTION ---
-class SobelFilter : public Filter {
+// Planar (SoA) frame: separate R, G and B planes, each a padded Gray8 plane.
+// Consecutive samples of one channel are adjacent, so kernels can load a whole
+// vector register of R (or G, or B) values at once instead of striding by 3 bytes.
+class PlanarImage {
+private:
+    GrayImage r, g, b;
+
 public:
-    string getName() override { return "Sobel Edge Detector"; }
-    
-    void apply(Image* src, Image* dest) override {
-        // Vertical (Gx) and Horizontal (Gy) Kernels
-        int gx[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
-        int gy[3][3] = {{-1, -2, -1}, {0, 0, 0}, {1, 2, 1}};
+    PlanarImage(int w, int h) : r(w, h), g(w, h), b(w, h) {}
 
-        for (int y = 1; y < src->getHeight() - 1; y++) {
-            for (int x = 1; x < src->getWidth() - 1; x++) {
-                int sumX = 0, sumY = 0;
+    int getWidth() const { return r.getWidth(); }
+    int getHeight() const { return r.getHeight(); }
 
-                // Convolution for Gradient Calculation
-                for (int i = -1; i <= 1; i++) {
-                    for (int j = -1; j <= 1; j++) {
-                        int val = src->getPixel(x+j, y+i).r;
-                        sumX += val * gx[i+1][j+1];
-                        sumY += val * gy[i+1][j+1];
-                    }
-                }
-                
-                // Approximate Magnitude = |Gx| + |Gy|
-                // This avoids square root (sqrt) which is expensive in hardware
-                int mag = abs(sumX) + abs(sumY);
-                uint8_t final = HardwareMath::clamp(mag);
-                dest->setPixel(x, y, {final, final, final});
+    // Channel 0 = R, 1 = G, 2 = B
+    GrayImage& getPlane(int c) { return c == 0 ? r : (c == 1 ? g : b); }
+    const GrayImage& getPlane(int c) const { return c == 0 ? r : (c == 1 ? g : b); }
+
+    void fillHalo(BorderMode mode) {
+        r.fillHalo(mode);
+        g.fillHalo(mode);
+        b.fillHalo(mode);
+    }
+
+    // Boundary conversions: packed RGB in (any view), packed RGB out
+    void fromInterleaved(const ImageView& img) {
+        int w = getWidth();
+        for (int y = 0; y < getHeight(); y++) {
+            const Pixel* px = img.row(y);
+            uint8_t* pr = r.row(y);
+            uint8_t* pg = g.row(y);
+            uint8_t* pb = b.row(y);
+            for (int x = 0; x < w; x++) {
+                pr[x] = px[x].r;
+                pg[x] = px[x].g;
+                pb[x] = px[x].b;
             }
         }
     }
+
+    void toInterleaved(Image* img) const {
+        int w = getWidth();
+        for (int y = 0; y < getHeight(); y++) {
+            Pixel* px = img->getData() + (size_t)y * w;
+            const uint8_t* pr = r.row(y);
+            const uint8_t* pg = g.row(y);
+            const uint8_t* pb = b.row(y);
+            for (int x = 0; x < w; x++) px[x] = {pr[x], pg[x], pb[x]};
+        }
+    }
+};
+
+// Which frame layout a pipeline works in between its input and output
+enum class FrameLayout { Interleaved, Planar };
+
+// --- Layout descriptors for layout-generic kernels ---
+// Reader::row(c, y) points at channel c of row y, with samples STEP bytes apart.
+// Writer::line(y) returns a functor storing the gray value v into pixel x of row y
+// (all channels). Both copy the frame's pointers into locals, so the compiler sees
+// plain arrays in the inner loops and can vectorize the planar case.
+// HAS_HALO layouts can be read one sample outside the frame (see GrayImage).
+struct InterleavedLayout {
+    using Frame = ImageView;
+    static constexpr int STEP = 3;
+    static constexpr bool HAS_HALO = false;
+    struct Reader {
+        const uint8_t* base;
+        size_t pitch;
+        explicit Reader(const ImageView* f)
+            : base(reinterpret_cast<const uint8_t*>(f->row(0))), pitch(f->getStride() * 3) {}
+        const uint8_t* row(int c, int y) const { return base + y * pitch + c; }
+    };
+    struct Writer {
+        Pixel* px;
+        size_t stride;
+        struct Line {
+            Pixel* p;
+            void operator()(int x, uint8_t v) const { p[x] = {v, v, v}; }
+        };
+        explicit Writer(ImageView* f) : px(f->row(0)), stride(f->getStride()) {}
+        Line line(int y) const { return {px + y * stride}; }
+    };
+};
+
+struct GrayLayout {
+    using Frame = GrayImage;
+    static constexpr int STEP = 1;
+    static constexpr bool HAS_HALO = true;
+    struct Reader {
+        const uint8_t* origin;
+        ptrdiff_t stride;
+        explicit Reader(const GrayImage* f) : origin(f->row(0)), stride((ptrdiff_t)f->getStride()) {}
+        const uint8_t* row(int, int y) const { return origin + y * stride; } // Every channel is the intensity
+    };
+    struct Writer {
+        uint8_t* origin;
+        ptrdiff_t stride;
+        struct Line {
+            uint8_t* d;
+            void operator()(int x, uint8_t v) const { d[x] = v; }
+        };
+        explicit Writer(GrayImage* f) : origin(f->row(0)), stride((ptrdiff_t)f->getStride()) {}
+        Line line(int y) const { return {origin + y * stride}; }
+    };
+};
+
+struct PlanarLayout {
+    using Frame = PlanarImage;
+    static constexpr int STEP = 1;
+    static constexpr bool HAS_HALO = true;
+    struct Reader {
+        GrayLayout::Reader planes[3];
+        explicit Reader(const PlanarImage* f)
+            : planes{GrayLayout::Reader(&f->getPlane(0)), GrayLayout::Reader(&f->getPlane(1)), GrayLayout::Reader(&f->getPlane(2))} {}
+        const uint8_t* row(int c, int y) const { return planes[c].row(0, y); }
+    };
+    struct Writer {
+        GrayLayout::Writer r, g, b;
+        struct Line {
+            uint8_t* r;
+            uint8_t* g;
+            uint8_t* b;
+            void operator()(int x, uint8_t v) const { r[x] = v; g[x] = v; b[x] = v; }
+        };
+        explicit Writer(PlanarImage* f) : r(&f->getPlane(0)), g(&f->getPlane(1)), b(&f->getPlane(2)) {}
+        Line line(int y) const { return {r.line(y).d, g.line(y).d, b.line(y).d}; }
+    };
 };
 
 // ============================================================
-// MODULE 6: PIPELINE MANAGER
+// MODULE 4: FILE I/O (Disk Operations)
 // ============================================================
-class Pipeline {
-    vector<Filter*> stages;
-    Image* workingBuffer;
+// Hand-written tokenizer for PNM text (header fields and P3 samples).
+// Works on a buffer that holds the whole file, so there are no per-number stream calls.
+// Separators follow the same rules as 'file >> value': C-locale whitespace,
+// and '#' starts a comment that runs to the end of the line.
+struct PNMScanner {
+    const char* pos;
+    const char* end;
 
-public:
-    Pipeline(Image* input) {
-        workingBuffer = new Image(*input); // Load input into pipeline memory
+    PNMScanner(const char* begin, const char* stop) : pos(begin), end(stop) {}
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
     }
 
-    ~Pipeline() {
-        if (workingBuffer) delete workingBuffer;
-        for (auto f : stages) delete f;
+    void skipSeparators() {
+        while (pos < end) {
+            if (isSpace(*pos)) {
+                pos++;
+            } else if (*pos == '#') {
+                while (pos < end && *pos != '\n') pos++; // Skip the entire comment line
+            } else {
+                break;
+            }
+        }
     }
 
-    void addStage(Filter* filter) {
-        stages.push_back(filter);
+    // Reads one (optionally signed) decimal integer. Returns false if none is found
+    // or its magnitude exceeds INT_MAX.
+    bool readInt(int& value) {
+        skipSeparators();
+        bool negative = false;
+        if (pos < end && (*pos == '-' || *pos == '+')) negative = (*pos++ == '-');
+        if (pos >= end || (unsigned)(*pos - '0') > 9) return false;
+
+        unsigned v = 0;
+        while (pos < end && (unsigned)(*pos - '0') <= 9) {
+            unsigned digit = (unsigned)(*pos++ - '0');
+            if (v > (INT_MAX - digit) / 10) return false; // Would overflow int
+            v = v * 10 + digit;
+        }
+        value = negative ? -(int)v : (int)v;
+        return true;
     }
+};
 
-    // MAIN EXECUTION LOGIC
-    void execute() {
-        Logger::log("CONTROL", "Initializing Pipeline...");
-        cout << "------------------------------------------------" << endl;
-        
-        // Secondary buffer for Double Buffering (Ping-Pong buffering)
-        Image* backBuffer = new Image(workingBuffer->getWidth(), workingBuffer->getHeight());
+// QOI ("Quite OK Image") lossless codec, dependency-free.
+// Byte-oriented ops (index / diff / luma / run / literal) give a compact stream
+// that encodes and decodes in one linear pass. Flat regions such as Sobel edge
+// maps collapse into run and index ops. Spec: https://qoiformat.org/qoi-specification.pdf
+namespace QOI {
+    const uint8_t OP_INDEX = 0x00; // 00xxxxxx
+    const uint8_t OP_DIFF  = 0x40; // 01xxxxxx
+    const uint8_t OP_LUMA  = 0x80; // 10xxxxxx
+    const uint8_t OP_RUN   = 0xc0; // 11xxxxxx
+    const uint8_t OP_RGB   = 0xfe;
+    const uint8_t OP_RGBA  = 0xff;
+    const uint8_t MASK_2   = 0xc0;
+    const size_t HEADER_SIZE = 14;
+    const uint8_t PADDING[8] = {0, 0, 0, 0, 0, 0, 0, 1};
 
-        int step = 1;
-        for (auto filter : stages) {
-            Logger::log("EXECUTE", "Stage " + to_string(step) + ": " + filter->getName());
-            
-            // 1. Apply Hardware Logic
-            filter->apply(workingBuffer, backBuffer);
+    struct RGBA { uint8_t r, g, b, a; };
 
-            // 2. Swap Buffers (Move data to next stage)
-            Image* temp = workingBuffer;
-            workingBuffer = backBuffer;
-            backBuffer = temp;
-            
-            // 3. Save Intermediate Output for Debugging
-            string filename = "debug_stage_" + to_string(step) + ".ppm";
-            IOHandler::savePPM(workingBuffer, filename);
-            Logger::hardwareLog("Debug frame saved: " + filename);
-            
-            step++;
-        }
-        delete backBuffer;
-        cout << "------------------------------------------------" << endl;
+    inline int hashIndex(const RGBA& p) { return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64; }
+
+    inline void writeU32(uint8_t* out, uint32_t v) {
+        out[0] = v >> 24; out[1] = v >> 16; out[2] = v >> 8; out[3] = v;
+    }
+    inline uint32_t readU32(const uint8_t* in) {
+        return (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 8 | in[3];
     }
 
-    Image* getResult() { return workingBuffer; }
-};
+    // Encodes an RGB frame into a complete .qoi byte stream
+    vector<char> encode(const Image* img) {
+        size_t count = (size_t)img->getWidth() * img->getHeight();
+        vector<char> out(HEADER_SIZE + count * 4 + sizeof(PADDING)); // Worst case
+        uint8_t* start = reinterpret_cast<uint8_t*>(out.data());
+        uint8_t* o = start;
 
-// ============================================================
-// MAIN APPLICATION
-// ============================================================
-int main() {
-    cout << "\n==============================================" << endl;
-    cout << "   FPGA IMAGE PROCESSING SIMULATOR (CLI)" << endl;
-    cout << "==============================================\n" << endl;
+        memcpy(o, "qoif", 4);
+        writeU32(o + 4, img->getWidth());
+        writeU32(o + 8, img->getHeight());
+        o[12] = 3; // RGB
+        o[13] = 0; // sRGB with linear alpha
+        o += HEADER_SIZE;
 
-    string filename;
-    Image* inputImg = nullptr;
+        RGBA index[64] = {};
+        RGBA prev = {0, 0, 0, 255};
+        int run = 0;
+        const Pixel* px = img->getData();
 
-    // User Input Loop
-    while (true) {
-        cout << "Enter input image filename (e.g., photo_ascii.ppm): ";
-        cin >> filename;
+        for (size_t i = 0; i < count; i++) {
+            RGBA cur = {px[i].r, px[i].g, px[i].b, 255};
+            if (cur.r == prev.r && cur.g == prev.g && cur.b == prev.b) {
+                run++;
+                if (run == 62 || i + 1 == count) { *o++ = OP_RUN | (run - 1); run = 0; }
+                continue;
+            }
+            if (run > 0) { *o++ = OP_RUN | (run - 1); run = 0; }
 
-        inputImg = IOHandler::loadPPM(filename);
-        if (inputImg != nullptr) break;
-        
-        cout << "[ERROR] File not found or invalid format!" << endl;
-        cout << "Hint: Ensure the file is PPM P3 (ASCII) format." << endl;
-        cout << "Try again? (y/n): ";
-        char choice; cin >> choice;
-        if (choice == 'n') return 0;
+            int slot = hashIndex(cur);
+            if (index[slot].r == cur.r && index[slot].g == cur.g && index[slot].b == cur.b && index[slot].a == cur.a) {
+                *o++ = OP_INDEX | slot;
+            } else {
+                index[slot] = cur;
+                int8_t dr = (int8_t)(cur.r - prev.r);
+                int8_t dg = (int8_t)(cur.g - prev.g);
+                int8_t db = (int8_t)(cur.b - prev.b);
+                int8_t drg = (int8_t)(dr - dg);
+                int8_t dbg = (int8_t)(db - dg);
+
+                if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2) {
+                    *o++ = OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+                } else if (dg > -33 && dg < 32 && drg > -9 && drg < 8 && dbg > -9 && dbg < 8) {
+                    *o++ = OP_LUMA | (dg + 32);
+                    *o++ = (drg + 8) << 4 | (dbg + 8);
+                } else {
+                    *o++ = OP_RGB;
+                    *o++ = cur.r; *o++ = cur.g; *o++ = cur.b;
+                }
+            }
+            prev = cur;
+        }
+
+        memcpy(o, PADDING, sizeof(PADDING));
+        o += sizeof(PADDING);
+        out.resize(o - start);
+        return out;
     }
 
-    // Pipeline Setup
-    Pipeline fpgaPipe(inputImg);
-    
-    // Add Processing Modules
-    fpgaPipe.addStage(new GrayscaleFilter());
-    fpgaPipe.addStage(new BlurFilter());
-    fpgaPipe.addStage(new SobelFilter());
+    // Decodes a .qoi byte stream (3 or 4 channels; alpha is dropped). Returns nullptr if malformed.
+    // A 'reuse' frame of matching size is decoded into in place instead of allocating.
+    unique_ptr<Image> decode(const uint8_t* data, size_t size, unique_ptr<Image> reuse = nullptr) {
+        if (size < HEADER_SIZE + sizeof(PADDING) || memcmp(data, "qoif", 4) != 0) return nullptr;
+        uint32_t w = readU32(data + 4), h = readU32(data + 8);
+        int channels = data[12];
+        if (w == 0 || h == 0 || (channels != 3 && channels != 4) || (uint64_t)w * h > 400000000ull) return nullptr;
 
-    // Run Simulation
-    fpgaPipe.execute();
+        bool fits = reuse && !reuse->isReadOnly() && reuse->getWidth() == (int)w && reuse->getHeight() == (int)h;
+        unique_ptr<Image> img = fits ? move(reuse) : make_unique<Image>((int)w, (int)h);
+        Pixel* px = img->getData();
+        size_t count = (size_t)w * h;
 
-    // Save Final Result
-    IOHandler::savePPM(fpgaPipe.getResult(), "final_output.ppm");
+        RGBA index[64] = {};
+        RGBA cur = {0, 0, 0, 255};
+        const uint8_t* in = data + HEADER_SIZE;
+        const uint8_t* end = data + size - sizeof(PADDING);
+        int run = 0;
 
-    // Cleanup
-    delete inputImg;
+        for (size_t i = 0; i < count; i++) {
+            if (run > 0) {
+                run--;
+            } else if (in < end) {
+                uint8_t b1 = *in++;
+                if (b1 == OP_RGB) {
+                    cur.r = in[0]; cur.g = in[1]; cur.b = in[2];
+                    in += 3;
+                } else if (b1 == OP_RGBA) {
+                    cur.r = in[0]; cur.g = in[1]; cur.b = in[2]; cur.a = in[3];
+                    in += 4;
+                } else if ((b1 & MASK_2) == OP_INDEX) {
+                    cur = index[b1];
+                } else if ((b1 & MASK_2) == OP_DIFF) {
+                    cur.r += ((b1 >> 4) & 0x03) - 2;
+                    cur.g += ((b1 >> 2) & 0x03) - 2;
+                    cur.b += (b1 & 0x03) - 2;
+                } else if ((b1 & MASK_2) == OP_LUMA) {
+                    uint8_t b2 = *in++;
+                    int dg = (b1 & 0x3f) - 32;
+                    cur.r += dg - 8 + ((b2 >> 4) & 0x0f);
+                    cur.g += dg;
+                    cur.b += dg - 8 + (b2 & 0x0f);
+                } else {
+                    run = b1 & 0x3f;
+                }
+                index[hashIndex(cur)] = cur;
+            } else {
+                return nullptr; // Stream ended before the last pixel
+            }
+            px[i] = {cur.r, cur.g, cur.b};
+        }
+        return img;
+    }
+}
+
+// Tiled container (.fpt) for images too large to hold in memory.
+// Layout (native little-endian):
+//   char     magic[8]  "FPGTILE1"
+//   uint32   width, height, tileSize, channels (3 = RGB)
+//   uint64   offsets[tilesX * tilesY + 1]   byte range of each tile, row-major; last = end of file
+//   tiles    each one tileW x tileH packed pixels (edge tiles are clipped to the image)
+// The offset index lets a reader fetch any region without touching the rest of the file.
+namespace TiledFormat {
+    const char MAGIC[8] = {'F', 'P', 'G', 'T', 'I', 'L', 'E', '1'};
+    const int DEFAULT_TILE_SIZE = 256;
+
+    struct Header {
+        char magic[8];
+        uint32_t width, height, tileSize, channels;
+    };
+    static_assert(sizeof(Header) == 24, "Tiled header must stay packed");
+}
+
+// Random-access reader: loads any rectangle by reading only the tiles it overlaps
+class TiledImageReader {
+    int fd = -1;
+    int width = 0, height = 0, tileSize = 0, tilesX = 0, tilesY = 0;
+    vector<uint64_t> offsets;
+    vector<char> staging; // Rows of one tile, reused for every read
+
+public:
+    ~TiledImageReader() { if (fd >= 0) close(fd); }
+
+    bool open(const string& filename) {
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            cerr << "[ERROR] File not found!" << endl;
+            return false;
+        }
+        TiledFormat::Header header;
+        if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            memcmp(header.magic, TiledFormat::MAGIC, 8) != 0 || header.channels != 3 ||
+            header.width == 0 || header.height == 0 || header.tileSize == 0 ||
+            header.width > INT32_MAX || header.height > INT32_MAX || header.tileSize > 65536) {
+            cerr << "[ERROR] Not a valid tiled image: " << filename << endl;
+            return false;
+        }
+        width = (int)header.width;
+        height = (int)header.height;
+        tileSize = (int)header.tileSize;
+        tilesX = (width + tileSize - 1) / tileSize;
+        tilesY = (height + tileSize - 1) / tileSize;
+
+        offsets.resize((size_t)tilesX * tilesY + 1);
+        size_t indexBytes = offsets.size() * sizeof(uint64_t);
+        if (pread(fd, offsets.data(), indexBytes, sizeof(header)) != (ssize_t)indexBytes) {
+            cerr << "[ERROR] Truncated tile index in " << filename << endl;
+            return false;
+        }
+        Logger::log("DMA_READ", "Tiled file: " + filename);
+        Logger::hardwareLog("Resolution detected: " + to_string(width) + "x" + to_string(height) +
+                            " (" + to_string(tilesX * tilesY) + " tiles of " + to_string(tileSize) + ")");
+        return true;
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getTileSize() const { return tileSize; }
+
+    // Copies the rectangle (x, y, frame width x frame height) into 'frame'.
+    // Each overlapped tile costs one read of just the tile rows inside the rectangle.
+    bool readRegion(int x, int y, Image* frame) {
+        int w = frame->getWidth(), h = frame->getHeight();
+        Pixel* dst = frame->getData();
+        for (int ty = y / tileSize; ty <= (y + h - 1) / tileSize; ty++) {
+            int tileY = ty * tileSize;
+            int y0 = max(y, tileY), y1 = min(y + h, min(tileY + tileSize, height));
+            for (int tx = x / tileSize; tx <= (x + w - 1) / tileSize; tx++) {
+                int tileX = tx * tileSize;
+                int tileW = min(tileSize, width - tileX);
+                int x0 = max(x, tileX), x1 = min(x + w, tileX + tileW);
+
+                size_t rowBytes = (size_t)tileW * sizeof(Pixel);
+                size_t bytes = (size_t)(y1 - y0) * rowBytes;
+                uint64_t offset = offsets[(size_t)ty * tilesX + tx] + (uint64_t)(y0 - tileY) * rowBytes;
+                staging.resize(bytes);
+                if (pread(fd, staging.data(), bytes, (off_t)offset) != (ssize_t)bytes) {
+                    cerr << "[ERROR] Truncated tile " << tx << "," << ty << endl;
+                    return false;
+                }
+                const Pixel* src = reinterpret_cast<const Pixel*>(staging.data()) + (x0 - tileX);
+                for (int row = y0; row < y1; row++) {
+                    memcpy(dst + (size_t)(row - y) * w + (x0 - x), src, (size_t)(x1 - x0) * sizeof(Pixel));
+                    src += tileW;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+// Sequential writer: the index is known up front (tiles are stored raw),
+// so tiles are appended in row-major order as soon as each one is finished
+class TiledImageWriter {
+    ofstream file;
+    int width = 0, height = 0, tileSize = 0;
+
+public:
+    bool open(const string& filename, int w, int h, int tile = TiledFormat::DEFAULT_TILE_SIZE) {
+        file.open(filename, ios::binary);
+        if (!file) {
+            cerr << "[ERROR] Cannot create " << filename << endl;
+            return false;
+        }
+        width = w;
+        height = h;
+        tileSize = tile;
+        int tilesX = (w + tile - 1) / tile, tilesY = (h + tile - 1) / tile;
+
+        TiledFormat::Header header;
+        memcpy(header.magic, TiledFormat::MAGIC, 8);
+        header.width = (uint32_t)w;
+        header.height = (uint32_t)h;
+        header.tileSize = (uint32_t)tile;
+        header.channels = 3;
+
+        vector<uint64_t> offsets;
+        offsets.reserve((size_t)tilesX * tilesY + 1);
+        uint64_t offset = sizeof(header) + ((size_t)tilesX * tilesY + 1) * sizeof(uint64_t);
+        for (int ty = 0; ty < tilesY; ty++) {
+            for (int tx = 0; tx < tilesX; tx++) {
+                offsets.push_back(offset);
+                offset += (uint64_t)min(tile, w - tx * tile) * min(tile, h - ty * tile) * sizeof(Pixel);
+            }
+        }
+        offsets.push_back(offset);
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+        return (bool)file;
+    }
+
+    int getTileSize() const { return tileSize; }
+
+    // Appends the next tile (row-major order): tileW x tileH pixels starting at
+    // 'topLeft' inside a larger buffer whose rows are 'stride' pixels apart
+    void writeTile(const Pixel* topLeft, int stride, int tileW, int tileH) {
+        for (int row = 0; row < tileH; row++) {
+            file.write(reinterpret_cast<const char*>(topLeft + (size_t)row * stride), (size_t)tileW * sizeof(Pixel));
+        }
+    }
+
+    bool close() {
+        file.close();
+        return !file.fail();
+    }
+};
+
+class IOHandler {
+public:
+    // .ppm results are written as binary P6 instead of P3 text (--binary)
+    static inline bool binaryPPM = false;
+
+    // Helper function to skip comments (lines starting with #) in PPM files
+    static void ignoreComments(istream& file) {
+        while (file >> ws && file.peek() == '#') {
+            file.ignore(4096, '\n'); // Skip the entire comment line
+        }
+    }
+
+    // Reads the "W H MaxVal" part of a PNM header (after the magic number)
+    static bool readHeader(istream& file, int& w, int& h, int& maxVal) {
+        ignoreComments(file); file >> w;
+        ignoreComments(file); file >> h;
+        ignoreComments(file); file >> maxVal;
+        return file && w > 0 && h > 0 && maxVal > 0;
+    }
+
+    // Files with a P3 payload above this size are decoded on several worker threads
+    static constexpr size_t PARALLEL_PARSE_MIN_BYTES = 8u << 20;
+
+    // Buffer for a w x h decode: 'reuse' if it already has that size, otherwise a new Image
+    // (allocated before 'reuse' is freed, so the two never share an address)
+    static unique_ptr<Image> frameBuffer(int w, int h, unique_ptr<Image> reuse) {
+        if (reuse && !reuse->isReadOnly() && reuse->getWidth() == w && reuse->getHeight() == h) return reuse;
+        return make_unique<Image>(w, h);
+    }
+
+    // parseThreads: 0 = choose automatically from the payload size and CPU count
+    // reuse: optional frame decoded into in place when the resolution matches (pooled buffers).
+    //        The result is 'reuse' itself or a new Image; a 'reuse' frame that is not
+    //        returned is freed (also on failure, which returns nullptr).
+    static unique_ptr<Image> loadPPM(const string& filename, unsigned parseThreads = 0, unique_ptr<Image> reuse = nullptr) {
+        Logger::log("DMA_READ", "Loading file: " + filename);
+        ifstream file(filename, ios::binary);
+        
+        if (!file) {
+            cerr << "[ERROR] File not found!" << endl;
+            return nullptr;
+        }
+
+        // QOI files are recognised by their "qoif" magic, tiled files by "FPGTILE1"
+        char magic[8] = {};
+        file.read(magic, 8);
+        if (file.gcount() >= 4 && memcmp(magic, "qoif", 4) == 0) {
+            file.clear(); // Tiny files stop short of 8 bytes
+            return loadQOI(file, filename, move(reuse));
+        }
+        if (file.gcount() == 8 && memcmp(magic, TiledFormat::MAGIC, 8) == 0) {
+            return loadTiled(filename, move(reuse));
+        }
+        file.clear();
+        file.seekg(0);
+
+        string format;
+
+        // Read PPM Header
+        file >> format;
+        if (format == "P6" || format == "P5") {
+            return loadBinary(file, format, filename, move(reuse));
+        }
+        if (format != "P3") {
+            cerr << "[ERROR] Invalid Format. Please use PPM (P3/P6), PGM (P5) or QOI." << endl;
+            return nullptr;
+        }
+
+        // Slurp the rest of the file with ONE read, then decode it from memory
+        streampos start = file.tellg();
+        file.seekg(0, ios::end);
+        size_t length = (size_t)(file.tellg() - start);
+        file.seekg(start);
+        vector<char> text(length);
+        file.read(text.data(), length);
+
+        return decodeP3Text(text.data(), text.data() + file.gcount(), filename, parseThreads, move(reuse));
+    }
+
+    // Decodes P3 text that follows the "P3" magic (header fields + samples)
+    static unique_ptr<Image> decodeP3Text(const char* begin, const char* end, const string& filename,
+                                          unsigned parseThreads = 0, unique_ptr<Image> reuse = nullptr) {
+        int w, h, maxVal;
+        PNMScanner scanner(begin, end);
+        if (!scanner.readInt(w) || !scanner.readInt(h) || !scanner.readInt(maxVal) ||
+            w <= 0 || h <= 0 || maxVal <= 0) {
+            cerr << "[ERROR] Corrupted header in " << filename << endl;
+            return nullptr;
+        }
+
+        Logger::hardwareLog("Resolution detected: " + to_string(w) + "x" + to_string(h));
+        
+        unique_ptr<Image> img = frameBuffer(w, h, move(reuse));
+        uint8_t* out = reinterpret_cast<uint8_t*>(img->getData());
+        size_t samples = (size_t)w * h * 3;
+        size_t payload = (size_t)(scanner.end - scanner.pos);
+
+        unsigned threads = parseThreads;
+        if (threads == 0) {
+            threads = (payload >= PARALLEL_PARSE_MIN_BYTES) ? thread::hardware_concurrency() : 1;
+        }
+        if (threads > 1 && decodeP3Parallel(scanner, out, samples, threads)) {
+            Logger::hardwareLog("P3 payload decoded on " + to_string(threads) + " threads");
+            return img;
+        }
+        decodeP3(scanner, out, samples, filename);
+        return img;
+    }
+
+    // Multithreaded P3 decode:
+    //   1. Cut the payload into chunks whose edges fall on whitespace (no number is split).
+    //   2. Each worker counts the numbers in its chunk.
+    //   3. A prefix sum over the counts gives each chunk its first sample index.
+    //   4. Each worker decodes its chunk straight into its slice of the pixel buffer.
+    // Returns false (caller falls back to the serial decoder) when the payload has
+    // comments, malformed tokens or a sample count mismatch.
+    static bool decodeP3Parallel(const PNMScanner& scanner, uint8_t* out, size_t samples, unsigned threads) {
+        const char* begin = scanner.pos;
+        const char* end = scanner.end;
+        size_t length = (size_t)(end - begin);
+        if (memchr(begin, '#', length)) return false; // Comments could straddle chunk edges
+
+        threads = (unsigned)min<size_t>(threads, max<size_t>(1, length / (1u << 20)));
+        if (threads < 2) return false;
+
+        vector<const char*> edges(threads + 1);
+        edges[0] = begin;
+        edges[threads] = end;
+        for (unsigned t = 1; t < threads; t++) {
+            const char* p = max(begin + length / threads * t, edges[t - 1]);
+            while (p < end && !PNMScanner::isSpace(*p)) p++;
+            edges[t] = p;
+        }
+
+        // Pass 1: count numbers per chunk (a number starts after a separator)
+        vector<size_t> counts(threads, 0);
+        vector<thread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                size_t n = 0;
+                bool inToken = false;
+                for (const char* p = edges[t]; p < edges[t + 1]; p++) {
+                    bool space = PNMScanner::isSpace(*p);
+                    if (!space && !inToken) n++;
+                    inToken = !space;
+                }
+                counts[t] = n;
+            });
+        }
+        for (auto& w : workers) w.join();
+        workers.clear();
+
+        // Prefix sum -> first sample index of every chunk
+        vector<size_t> first(threads + 1, 0);
+        for (unsigned t = 0; t < threads; t++) first[t + 1] = first[t] + counts[t];
+        if (first[threads] < samples) return false; // Truncated file: serial path reports it
+
+        // Pass 2: decode every chunk into its own slice of the memory block.
+        // A chunk whose numbers do not line up with its token count (e.g. "12+34"
+        // decodes as two numbers) would shift every later chunk: fall back instead.
+        vector<char> ok(threads, 1);
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                PNMScanner chunk(edges[t], edges[t + 1]);
+                size_t stop = min(first[t + 1], samples);
+                int v;
+                for (size_t i = first[t]; i < stop; i++) {
+                    if (!chunk.readInt(v)) { ok[t] = 0; return; }
+                    out[i] = (uint8_t)v;
+                }
+                if (stop == first[t + 1]) {
+                    chunk.skipSeparators();
+                    if (chunk.pos != chunk.end) ok[t] = 0;
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+        return all_of(ok.begin(), ok.end(), [](char c) { return c != 0; });
+    }
+
+    // Decodes 'samples' ASCII channel values straight into the pixel memory block.
+    // Values are truncated to 8 bits exactly like the original (uint8_t) cast.
+    static void decodeP3(PNMScanner& scanner, uint8_t* out, size_t samples, const string& filename) {
+        size_t i = 0;
+        int v;
+        while (i < samples && scanner.readInt(v)) {
+            out[i++] = (uint8_t)v;
+        }
+        if (i < samples) {
+            cerr << "[WARNING] " << filename << " ends after " << i << " of " << samples
+                 << " samples; remaining pixels set to 0." << endl;
+            for (; i < samples; i++) out[i] = 0;
+        }
+    }
+
+    // Decodes a complete file image that is already in memory (P3, P6, P5 or QOI)
+    static unique_ptr<Image> decodeMemory(const char* data, size_t size, const string& filename,
+                                          unique_ptr<Image> reuse = nullptr) {
+        if (size >= 4 && memcmp(data, "qoif", 4) == 0) {
+            unique_ptr<Image> img = QOI::decode(reinterpret_cast<const uint8_t*>(data), size, move(reuse));
+            if (!img) cerr << "[ERROR] Corrupted QOI stream in " << filename << endl;
+            return img;
+        }
+        if (size < 2 || data[0] != 'P' || (data[1] != '3' && data[1] != '5' && data[1] != '6')) {
+            cerr << "[ERROR] Invalid Format. Please use PPM (P3/P6), PGM (P5) or QOI." << endl;
+            return nullptr;
+        }
+        if (data[1] == '3') return decodeP3Text(data + 2, data + size, filename, 0, move(reuse));
+
+        int w, h, maxVal;
+        PNMScanner scanner(data + 2, data + size);
+        if (!scanner.readInt(w) || !scanner.readInt(h) || !scanner.readInt(maxVal) ||
+            w <= 0 || h <= 0 || maxVal > 255) {
+            cerr << "[ERROR] Corrupted header in " << filename << endl;
+            return nullptr;
+        }
+        size_t offset = (size_t)(scanner.pos - data) + 1;
+        size_t count = (size_t)w * h;
+        size_t bytes = (data[1] == '6') ? count * sizeof(Pixel) : count;
+        if (offset + bytes > size) {
+            cerr << "[ERROR] Unexpected end of pixel data in " << filename << endl;
+            return nullptr;
+        }
+
+        unique_ptr<Image> img = frameBuffer(w, h, move(reuse));
+        memcpy(img->getData(), data + offset, bytes);
+        if (data[1] == '5') expandGray(img.get());
+        return img;
+    }
+
+    // Expands 'width*height' gray bytes stored at the front of the frame into {v,v,v} pixels.
+    // Walking backwards never overwrites a gray byte that is still unread.
+    static void expandGray(Image* img) {
+        size_t count = (size_t)img->getWidth() * img->getHeight();
+        const uint8_t* gray = reinterpret_cast<const uint8_t*>(img->getData());
+        Pixel* px = img->getData();
+        for (size_t i = count; i-- > 0; ) {
+            uint8_t v = gray[i];
+            px[i] = {v, v, v};
+        }
+    }
+
+    // Optional asynchronous destination for finished files (e.g. the io_uring batch writer).
+    // When empty, files are written synchronously with one bulk write.
+    static inline function<void(const string&, vector<char>&&)> fileSink;
+
+    static void writeFile(const string& filename, vector<char>&& bytes) {
+        if (fileSink) {
+            fileSink(filename, move(bytes));
+            return;
+        }
+        ofstream file(filename, ios::binary);
+        file.write(bytes.data(), bytes.size());
+        file.close();
+    }
+
+    // QOI decoder front end: the compressed stream is read with ONE bulk read
+    static unique_ptr<Image> loadQOI(ifstream& file, const string& filename, unique_ptr<Image> reuse = nullptr) {
+        file.seekg(0, ios::end);
+        size_t size = (size_t)file.tellg();
+        file.seekg(0);
+        vector<uint8_t> data(size);
+        file.read(reinterpret_cast<char*>(data.data()), size);
+
+        unique_ptr<Image> img = QOI::decode(data.data(), (size_t)file.gcount(), move(reuse));
+        if (!img) {
+            cerr << "[ERROR] Corrupted QOI stream in " << filename << endl;
+            return nullptr;
+        }
+        Logger::hardwareLog("Resolution detected: " + to_string(img->getWidth()) + "x" + to_string(img->getHeight()) + " (QOI)");
+        return img;
+    }
+
+    // Reference P3 loader (one formatted stream extraction per channel).
+    // Kept to benchmark and cross-check the fast parser in loadPPM().
+    static unique_ptr<Image> loadPPMStream(const string& filename) {
+        ifstream file(filename);
+        string format;
+        int w, h, maxVal;
+
+        file >> format;
+        if (format != "P3" || !readHeader(file, w, h, maxVal)) return nullptr;
+
+        auto img = make_unique<Image>(w, h);
+        int r, g, b;
+        
+        // Load Pixel Data into RAM
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                file >> r >> g >> b;
+                img->setPixel(x, y, {(uint8_t)r, (uint8_t)g, (uint8_t)b});
+            }
+        }
+        return img;
+    }
+
+    // Whole-image load of a tiled file (small images / viewing). Large scans go
+    // through the tiled executor instead, which only holds one tile at a time.
+    static unique_ptr<Image> loadTiled(const string& filename, unique_ptr<Image> reuse = nullptr) {
+        TiledImageReader reader;
+        if (!reader.open(filename)) return nullptr;
+        unique_ptr<Image> img = frameBuffer(reader.getWidth(), reader.getHeight(), move(reuse));
+        if (!reader.readRegion(0, 0, img.get())) return nullptr;
+        return img;
+    }
+
+    // Fast path for binary P6 (RGB) and P5 (Gray) files.
+    // The whole pixel payload is moved with ONE bulk read (Burst DMA transfer).
+    static unique_ptr<Image> loadBinary(ifstream& file, const string& format, const string& filename,
+                                        unique_ptr<Image> reuse = nullptr) {
+        int w, h, maxVal;
+        if (!readHeader(file, w, h, maxVal)) {
+            cerr << "[ERROR] Corrupted header in " << filename << endl;
+            return nullptr;
+        }
+        if (maxVal > 255) {
+            cerr << "[ERROR] 16-bit samples are not supported (MaxVal " << maxVal << ")." << endl;
+            return nullptr;
+        }
+        file.get(); // Exactly one whitespace byte separates header and payload
+
+        // Reject a truncated payload before allocating the frame (a corrupt header
+        // must not trigger a huge allocation)
+        size_t count = (size_t)w * h;
+        size_t bytes = (format == "P6") ? count * sizeof(Pixel) : count;
+        streampos payload = file.tellg();
+        file.seekg(0, ios::end);
+        streampos end = file.tellg();
+        file.seekg(payload);
+        if (payload < 0 || end < payload || (size_t)(end - payload) < bytes) {
+            cerr << "[ERROR] Unexpected end of pixel data in " << filename << endl;
+            return nullptr;
+        }
+
+        Logger::hardwareLog("Resolution detected: " + to_string(w) + "x" + to_string(h) + " (" + format + " binary)");
+
+        unique_ptr<Image> img = frameBuffer(w, h, move(reuse));
+        char* dst = reinterpret_cast<char*>(img->getData());
+
+        file.read(dst, bytes);
+        if ((size_t)file.gcount() != bytes) {
+            cerr << "[ERROR] Unexpected end of pixel data in " << filename << endl;
+            return nullptr;
+        }
+
+        if (format == "P5") {
+            expandGray(img.get()); // Gray bytes landed in the front of the buffer
+        }
+        return img;
+    }
+
+    // Lookup table: decimal text of every 8-bit value followed by a space ("0 " .. "255 ")
+    struct SampleText {
+        char text[4];
+        uint8_t length;
+    };
+
+    static const SampleText* sampleTable() {
+        static const array<SampleText, 256> table = [] {
+            array<SampleText, 256> t{};
+            for (int v = 0; v < 256; v++) {
+                string text = to_string(v) + " ";
+                memcpy(t[v].text, text.data(), text.size());
+                t[v].length = (uint8_t)text.size();
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    // Formats one row of P3 text ("r g b " per pixel + '\n') and returns the new end.
+    // 'out' needs room for 12 bytes per pixel + 1.
+    static char* formatP3Row(const Pixel* row, int width, char* out) {
+        const SampleText* table = sampleTable();
+        const uint8_t* px = reinterpret_cast<const uint8_t*>(row);
+        for (int i = 0; i < width * 3; i++) {
+            const SampleText& s = table[*px++];
+            memcpy(out, s.text, 4); // Fixed-size copy; only 'length' bytes are kept
+            out += s.length;
+        }
+        *out++ = '\n';
+        return out;
+    }
+
+    // P3 writer: the whole file is formatted into one preallocated buffer and
+    // flushed with a single write. Layout: "r g b " per pixel, '\n' per row.
+    static void savePPM(const Image* img, const string& filename) {
+        int w = img->getWidth(), h = img->getHeight();
+        string header = "P3\n" + to_string(w) + " " + to_string(h) + "\n255\n";
+
+        // Worst case is 4 bytes per sample ("255 ") plus one newline per row
+        vector<char> buffer(header.size() + (size_t)w * h * 3 * 4 + h);
+        char* out = buffer.data();
+        memcpy(out, header.data(), header.size());
+        out += header.size();
+
+        for (int y = 0; y < h; y++) {
+            out = formatP3Row(img->getData() + (size_t)y * w, w, out);
+        }
+
+        buffer.resize(out - buffer.data());
+        writeFile(filename, move(buffer));
+    }
+
+    // Zero-copy loader: maps the file into memory and points the Image at the P6 payload.
+    // Pixels are read straight from the page cache; nothing is allocated or copied.
+    // Formats that need decoding (P3 text, P5 expansion) fall back to loadPPM().
+    static unique_ptr<Image> mapPPM(const string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return loadPPM(filename); // loadPPM reports the error
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < 3) {
+            close(fd);
+            return loadPPM(filename);
+        }
+        size_t length = (size_t)st.st_size;
+        void* base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // The mapping stays valid after closing the descriptor
+        if (base == MAP_FAILED) return loadPPM(filename);
+
+        const char* mem = static_cast<const char*>(base);
+        if (mem[0] != 'P' || mem[1] != '6') {
+            munmap(base, length);
+            return loadPPM(filename);
+        }
+
+        // Parse "W H MaxVal" directly from the mapped header
+        PNMScanner scanner(mem + 2, mem + length);
+        int w, h, maxVal;
+        if (!scanner.readInt(w) || !scanner.readInt(h) || !scanner.readInt(maxVal)) {
+            munmap(base, length);
+            return loadPPM(filename);
+        }
+        size_t pos = (size_t)(scanner.pos - mem) + 1; // Single whitespace byte before the payload
+
+        size_t bytes = (size_t)w * h * sizeof(Pixel);
+        if (w <= 0 || h <= 0 || maxVal > 255 || pos + bytes > length) {
+            munmap(base, length);
+            return loadPPM(filename); // Let the regular loader report the problem
+        }
+
+        madvise(base, length, MADV_SEQUENTIAL); // Pipeline reads the frame front to back
+        Logger::log("DMA_READ", "Mapping file: " + filename);
+        Logger::hardwareLog("Resolution detected: " + to_string(w) + "x" + to_string(h) + " (P6 zero-copy, " + to_string(bytes) + " bytes mapped)");
+
+        return make_unique<Image>(w, h, reinterpret_cast<const Pixel*>(mem + pos), base, length);
+    }
+
+    // Binary PPM (P6) writer: header + ONE bulk write of the memory block
+    static void savePPMBinary(const Image* img, const string& filename) {
+        string header = "P6\n" + to_string(img->getWidth()) + " " + to_string(img->getHeight()) + "\n255\n";
+        size_t bytes = (size_t)img->getWidth() * img->getHeight() * sizeof(Pixel);
+        const char* payload = reinterpret_cast<const char*>(img->getData());
+
+        if (fileSink) {
+            // Asynchronous sinks need a buffer that outlives the frame
+            vector<char> buffer(header.begin(), header.end());
+            buffer.insert(buffer.end(), payload, payload + bytes);
+            writeFile(filename, move(buffer));
+            return;
+        }
+        ofstream file(filename, ios::binary);
+        file << header;
+        file.write(payload, bytes);
+        file.close();
+    }
+
+    // Binary PGM (P5) writer: stores the intensity (Red) channel only
+    static void savePGM(const Image* img, const string& filename) {
+        string header = "P5\n" + to_string(img->getWidth()) + " " + to_string(img->getHeight()) + "\n255\n";
+        size_t count = (size_t)img->getWidth() * img->getHeight();
+        vector<char> buffer(header.size() + count);
+        memcpy(buffer.data(), header.data(), header.size());
+        char* gray = buffer.data() + header.size();
+        const Pixel* px = img->getData();
+        for (size_t i = 0; i < count; i++) gray[i] = (char)px[i].r;
+        writeFile(filename, move(buffer));
+    }
+
+    // Gray8 frames are already the P5 payload
+    static void savePGM(const GrayImage* img, const string& filename) {
+        string header = "P5\n" + to_string(img->getWidth()) + " " + to_string(img->getHeight()) + "\n255\n";
+        size_t count = (size_t)img->getWidth() * img->getHeight();
+        vector<char> buffer(header.size() + count);
+        memcpy(buffer.data(), header.data(), header.size());
+        char* gray = buffer.data() + header.size();
+        for (int y = 0; y < img->getHeight(); y++) {
+            memcpy(gray + (size_t)y * img->getWidth(), img->row(y), img->getWidth()); // Rows are padded
+        }
+        writeFile(filename, move(buffer));
+    }
+
+    // QOI writer: encodes into one buffer, flushed with a single write
+    static void saveQOI(const Image* img, const string& filename) {
+        writeFile(filename, QOI::encode(img));
+    }
+
+    // Tiled container writer (written directly, tile by tile)
+    static void saveTiled(const Image* img, const string& filename) {
+        TiledImageWriter writer;
+        if (!writer.open(filename, img->getWidth(), img->getHeight())) return;
+        int w = img->getWidth(), h = img->getHeight(), t = writer.getTileSize();
+        for (int y = 0; y < h; y += t) {
+            for (int x = 0; x < w; x += t) {
+                writer.writeTile(img->getData() + (size_t)y * w + x, w, min(t, w - x), min(t, h - y));
+            }
+        }
+        if (!writer.close()) cerr << "[ERROR] Write failed: " << filename << endl;
+    }
+
+    // Picks the writer from the file extension: .qoi, .fpt (tiled), .pgm (P5),
+    // otherwise P3 text (or P6 with binaryPPM)
+    static void saveImage(const Image* img, const string& filename) {
+        auto endsWith = [&filename](const string& ext) {
+            return filename.size() >= ext.size() &&
+                   filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+        };
+        if (endsWith(".qoi")) saveQOI(img, filename);
+        else if (endsWith(".fpt")) saveTiled(img, filename);
+        else if (endsWith(".pgm")) savePGM(img, filename);
+        else if (binaryPPM) savePPMBinary(img, filename);
+        else savePPM(img, filename);
+    }
+};
+
+// ------------------------------------------------------------
+// Y4M (YUV4MPEG2) video streams
+// ------------------------------------------------------------
+// Camera captures arrive as raw YUV video: one text header for the stream,
+// then "FRAME\n" + Y plane + chroma planes per frame. Only the luma plane is
+// processed; it already is the grayscale image, so no RGB conversion is needed.
+
+// Stream header fields shared by reader and writer
+struct Y4MFormat {
+    int width = 0, height = 0;
+    string frameRate = "F25:1", interlace = "Ip", aspect = "A1:1";
+    size_t chromaBytes = 0; // Both chroma planes of one frame
+
+    // Chroma plane sizes for the 8-bit colour spaces; false for anything else (e.g. C420p10)
+    bool setColorspace(const string& tag) {
+        size_t cw = (size_t)(width + 1) / 2, ch = (size_t)(height + 1) / 2;
+        if (tag == "420jpeg" || tag == "420paldv" || tag == "420mpeg2" || tag == "420") chromaBytes = cw * ch * 2;
+        else if (tag == "422") chromaBytes = cw * height * 2;
+        else if (tag == "444") chromaBytes = (size_t)width * height * 2;
+        else if (tag == "mono") chromaBytes = 0;
+        else return false;
+        return true;
+    }
+};
+
+// Reads Y4M frames one by one from a file or stdin ("-").
+// The same frame buffer is refilled for every frame of the stream.
+class Y4MReader {
+    ifstream file;
+    istream* in = nullptr;
+    Y4MFormat format;
+    vector<char> chroma; // Skipped chroma planes (stdin cannot seek)
+    long long framesRead = 0;
+
+public:
+    bool open(const string& filename) {
+        if (filename == "-") {
+            in = &cin;
+        } else {
+            file.open(filename, ios::binary);
+            if (!file) {
+                cerr << "[ERROR] File not found!" << endl;
+                return false;
+            }
+            in = &file;
+        }
+
+        string header;
+        if (!getline(*in, header) || header.compare(0, 10, "YUV4MPEG2 ") != 0) {
+            cerr << "[ERROR] Not a YUV4MPEG2 stream: " << filename << endl;
+            return false;
+        }
+        string colorspace = "420jpeg";
+        size_t pos = 10;
+        while (pos < header.size()) {
+            size_t next = header.find(' ', pos);
+            if (next == string::npos) next = header.size();
+            string token = header.substr(pos, next - pos);
+            pos = next + 1;
+            if (token.empty()) continue;
+            switch (token[0]) {
+                case 'W': format.width = atoi(token.c_str() + 1); break;
+                case 'H': format.height = atoi(token.c_str() + 1); break;
+                case 'F': format.frameRate = token; break;
+                case 'I': format.interlace = token; break;
+                case 'A': format.aspect = token; break;
+                case 'C': colorspace = token.substr(1); break;
+                default: break; // X (comments/extensions) and unknown tags are ignored
+            }
+        }
+        if (format.width <= 0 || format.height <= 0 || !format.setColorspace(colorspace)) {
+            cerr << "[ERROR] Unsupported Y4M stream (" << format.width << "x" << format.height
+                 << ", C" << colorspace << "); 8-bit 4:2:0, 4:2:2, 4:4:4 or mono required" << endl;
+            return false;
+        }
+        chroma.resize(format.chromaBytes);
+        Logger::log("DMA_READ", "Video stream: " + filename);
+        Logger::hardwareLog("Resolution detected: " + to_string(format.width) + "x" + to_string(format.height) + " (Y4M C" + colorspace + ")");
+        return true;
+    }
+
+    const Y4MFormat& getFormat() const { return format; }
+
+    // Reads the next frame's luma plane into 'luma' (width x height), row by row
+    // into its padded rows. Returns false at the end of the stream.
+    bool readFrame(GrayImage* luma) {
+        string marker;
+        if (!getline(*in, marker)) return false;
+        if (marker.compare(0, 5, "FRAME") != 0) {
+            cerr << "[ERROR] Y4M frame " << framesRead << ": missing FRAME marker" << endl;
+            return false;
+        }
+
+        for (int y = 0; y < format.height && *in; y++) {
+            in->read(reinterpret_cast<char*>(luma->row(y)), format.width);
+        }
+        if (*in) in->read(chroma.data(), chroma.size());
+        if (!*in) {
+            cerr << "[WARNING] Y4M stream ends inside frame " << framesRead << "; frame dropped." << endl;
+            return false;
+        }
+        framesRead++;
+        return true;
+    }
+};
+
+// Writes Y4M frames (C420jpeg, neutral chroma). Each frame goes out with one write;
+// the chroma planes are filled once and reused for every frame.
+class Y4MWriter {
+    ofstream file;
+    vector<char> frameBytes; // "FRAME\n" + Y plane + constant chroma planes
+    int width = 0, height = 0;
+
+public:
+    bool open(const string& filename, const Y4MFormat& source) {
+        file.open(filename, ios::binary);
+        if (!file) {
+            cerr << "[ERROR] Cannot create " << filename << endl;
+            return false;
+        }
+        Y4MFormat out = source;
+        out.setColorspace("420jpeg");
+        file << "YUV4MPEG2 W" << out.width << " H" << out.height << " " << out.frameRate
+             << " " << out.interlace << " " << out.aspect << " C420jpeg\n";
+
+        width = out.width;
+        height = out.height;
+        frameBytes.assign(6 + (size_t)width * height + out.chromaBytes, (char)128);
+        memcpy(frameBytes.data(), "FRAME\n", 6);
+        return true;
+    }
+
+    // Stores a Gray8 frame as luma
+    void writeFrame(const GrayImage* gray) {
+        char* luma = frameBytes.data() + 6;
+        for (int y = 0; y < height; y++) memcpy(luma + (size_t)y * width, gray->row(y), (size_t)width);
+        file.write(frameBytes.data(), frameBytes.size());
+    }
+};
+
+// ------------------------------------------------------------
+// Concatenated PNM frames (pipe mode)
+// ------------------------------------------------------------
+// A capture process writes binary P6/P5 frames back to back into our stdin;
+// results leave on stdout in the same format for the next tool in the chain.
+
+class PNMFrameReader {
+    istream& in;
+    long long framesRead = 0;
+
+public:
+    explicit PNMFrameReader(istream& stream) : in(stream) {}
+
+    // Parses the next frame header; false at the end of the stream or on a malformed header
+    bool nextHeader(int& w, int& h, bool& gray) {
+        in >> ws;
+        if (in.peek() == EOF) return false;
+        string magic;
+        int maxVal;
+        in >> magic;
+        if ((magic != "P6" && magic != "P5") || !IOHandler::readHeader(in, w, h, maxVal) || maxVal > 255) {
+            cerr << "[ERROR] Pipe frame " << framesRead << ": expected an 8-bit P6 or P5 header" << endl;
+            return false;
+        }
+        in.get(); // Single whitespace byte before the binary payload
+        gray = (magic == "P5");
+        return true;
+    }
+
+    // Reads the payload straight into 'frame' (P5 gray is expanded in place)
+    bool readPayload(Image* frame, bool gray) {
+        size_t bytes = (size_t)frame->getWidth() * frame->getHeight() * (gray ? 1 : sizeof(Pixel));
+        in.read(reinterpret_cast<char*>(frame->getData()), bytes);
+        if ((size_t)in.gcount() != bytes) {
+            cerr << "[ERROR] Pipe frame " << framesRead << " is truncated" << endl;
+            return false;
+        }
+        if (gray) IOHandler::expandGray(frame);
+        framesRead++;
+        return true;
+    }
+};
+
+class PNMFrameWriter {
+    ostream& out;
+    vector<char> gray; // P5 staging plane, reused across frames
+
+public:
+    explicit PNMFrameWriter(ostream& stream) : out(stream) {}
+
+    // Writes one frame and flushes it, so the next tool sees it immediately
+    void writeFrame(const Image* img, bool asGray) {
+        int w = img->getWidth(), h = img->getHeight();
+        size_t count = (size_t)w * h;
+        out << (asGray ? "P5" : "P6") << "\n" << w << " " << h << "\n255\n";
+        if (asGray) {
+            gray.resize(count);
+            const Pixel* px = img->getData();
+            for (size_t i = 0; i < count; i++) gray[i] = (char)px[i].r;
+            out.write(gray.data(), count);
+        } else {
+            out.write(reinterpret_cast<const char*>(img->getData()), count * sizeof(Pixel));
+        }
+        out.flush();
+    }
+
+    // Gray8 results go out as P5 straight from the frame rows
+    void writeFrame(const GrayImage* img) {
+        out << "P5\n" << img->getWidth() << " " << img->getHeight() << "\n255\n";
+        for (int y = 0; y < img->getHeight(); y++) {
+            out.write(reinterpret_cast<const char*>(img->row(y)), img->getWidth());
+        }
+        out.flush();
+    }
+};
+
+// ============================================================
+// MODULE 5: FILTERS (Processing Cores)
+// ============================================================
+
+// Base Class (Polymorphism)
+class Filter {
+public:
+    virtual string getName() = 0;
+    // Views let a stage run on a region of interest (or a tile) inside a larger frame
+    virtual void apply(ImageView src, ImageView dest) = 0; // Pure Virtual Function
+    virtual ~Filter() {}
+
+    // --- Streaming (Line Buffer) Interface ---
+    // Produces output row 'y' from input rows y-1, y, y+1 (rows[0..2]).
+    // Rows outside the frame are all-zero rows (zero padding).
+    // 'out' arrives holding what the ping-pong buffer would hold in batch mode,
+    // so pixels a stage does not write come out the same in both modes.
+    virtual bool supportsRows() { return false; }
+    virtual void applyRow(const Pixel* const rows[3], Pixel* out, int width, int y, int height) {}
+
+    // Neighbourhood reach in pixels (1 for a 3x3 kernel). Tiled execution adds up
+    // the radii of all stages to size the halo around each tile.
+    virtual int getRadius() { return 1; }
+
+    // False for stages that leave some destination pixels untouched (they keep
+    // whatever the ping-pong buffer held before)
+    virtual bool writesAllPixels() { return true; }
+
+    // --- Gray8 Interface ---
+    // A stage whose output has r == g == b can write it as one byte per pixel;
+    // stages that only read intensity can then run on Gray8 frames.
+    virtual bool outputsGray() { return false; }
+    virtual void applyToGray(ImageView src, GrayImage* dest) {}
+    virtual bool supportsGray() { return false; }
+    virtual void applyGray(GrayImage* src, GrayImage* dest) {}
+
+    // --- Planar (SoA) Interface ---
+    // Stages that support planar frames provide both a planar -> planar kernel and,
+    // when outputsGray(), a planar -> Gray8 kernel.
+    virtual bool supportsPlanar() { return false; }
+    virtual void applyPlanar(PlanarImage* src, PlanarImage* dest) {}
+    virtual void applyPlanarToGray(PlanarImage* src, GrayImage* dest) {}
+};
+
+// --- STAGE 1: GRAYSCALE CONVERTER ---
+class GrayscaleFilter : public Filter {
+public:
+    string getName() override { return "Grayscale Converter"; }
+    int getRadius() override { return 0; } // Point operation
+    
+    void apply(ImageView src, ImageView dest) override {
+        for (int y = 0; y < src.getHeight(); y++) {
+            for (int x = 0; x < src.getWidth(); x++) {
+                Pixel p = src.getPixel(x, y);
+                // Standard Formula: 0.3R + 0.59G + 0.11B
+                // Hardware Optimization: Using integer multiplication and bit shift
+                int gray = (p.r * 77 + p.g * 150 + p.b * 29) >> 8; 
+                uint8_t val = HardwareMath::clamp(gray);
+                dest.setPixel(x, y, {val, val, val});
+            }
+        }
+    }
+
+    bool supportsRows() override { return true; }
+
+    void applyRow(const Pixel* const rows[3], Pixel* out, int width, int y, int height) override {
+        const Pixel* in = rows[1];
+        for (int x = 0; x < width; x++) {
+            int gray = (in[x].r * 77 + in[x].g * 150 + in[x].b * 29) >> 8;
+            uint8_t val = HardwareMath::clamp(gray);
+            out[x] = {val, val, val};
+        }
+    }
+
+    // Layout-generic kernel: with planar input each term is a contiguous byte array
+    template <typename In, typename Out>
+    static void convert(const typename In::Frame* src, typename Out::Frame* dest) {
+        const int S = In::STEP;
+        typename In::Reader in(src);
+        typename Out::Writer out(dest);
+        int w = src->getWidth(), h = src->getHeight();
+        for (int y = 0; y < h; y++) {
+            const uint8_t* r = in.row(0, y);
+            const uint8_t* g = in.row(1, y);
+            const uint8_t* b = in.row(2, y);
+            auto line = out.line(y);
+            for (int x = 0; x < w; x++) {
+                int gray = (r[x * S] * 77 + g[x * S] * 150 + b[x * S] * 29) >> 8;
+                line(x, HardwareMath::clamp(gray));
+            }
+        }
+    }
+
+    bool outputsGray() override { return true; }
+
+    void applyToGray(ImageView src, GrayImage* dest) override {
+        convert<InterleavedLayout, GrayLayout>(&src, dest);
+    }
+
+    bool supportsPlanar() override { return true; }
+
+    void applyPlanar(PlanarImage* src, PlanarImage* dest) override {
+        convert<PlanarLayout, PlanarLayout>(src, dest);
+    }
+
+    void applyPlanarToGray(PlanarImage* src, GrayImage* dest) override {
+        convert<PlanarLayout, GrayLayout>(src, dest);
+    }
+};
+
+// --- STAGE 2: GAUSSIAN BLUR (3x3) ---
+class BlurFilter : public Filter {
+    vector<uint16_t> sumRing; // Horizontal sums of three rows (see convolve)
+
+public:
+    string getName() override { return "Gaussian Blur (3x3)"; }
+
+    // The Gaussian kernel {1,2,1},{2,4,2},{1,2,1} is the outer product of [1 2 1]
+    // with itself, so the 9-tap convolution splits into a horizontal [1 2 1] pass and
+    // a vertical [1 2 1] pass: 6 taps per pixel instead of 9, each pass reading rows
+    // sequentially. A horizontal sum is at most 4 * 255 and the full sum at most
+    // 16 * 255, so 16-bit intermediates hold them exactly; the sum is never negative,
+    // so sum >> 4 equals the original sum / 16 and stays within 0..255.
+
+    // Horizontal pass of one row: out[x] = p[x-1] + 2 p[x] + p[x+1], samples S bytes
+    // apart. PADDED rows can be read at x = -1 and x = w; otherwise the edges see zeros.
+    template <int S, bool PADDED>
+    static void horizontal(const uint8_t* p, int w, uint16_t* out) {
+        if (PADDED) {
+            for (int x = 0; x < w; x++) out[x] = p[(x - 1) * S] + p[x * S] * 2 + p[(x + 1) * S];
+            return;
+        }
+        if (w < 2) {
+            if (w == 1) out[0] = p[0] * 2;
+            return;
+        }
+        out[0] = p[0] * 2 + p[S];
+        for (int x = 1; x < w - 1; x++) out[x] = p[(x - 1) * S] + p[x * S] * 2 + p[(x + 1) * S];
+        out[w - 1] = p[(w - 2) * S] + p[(w - 1) * S] * 2;
+    }
+
+    // Vertical pass over three rows of horizontal sums, then the normalisation
+    template <typename Line>
+    static void vertical(const uint16_t* up, const uint16_t* mid, const uint16_t* down, int w, Line line) {
+        for (int x = 0; x < w; x++) line(x, (uint8_t)((up[x] + mid[x] * 2 + down[x]) >> 4));
+    }
+
+    void apply(ImageView src, ImageView dest) override {
+        convolve<InterleavedLayout, InterleavedLayout>(&src, &dest); // Red channel as intensity
+    }
+
+    bool supportsRows() override { return true; }
+
+    void applyRow(const Pixel* const rows[3], Pixel* out, int width, int y, int height) override {
+        sumRing.resize(3 * (size_t)width);
+        uint16_t* sums[3];
+        for (int k = 0; k < 3; k++) {
+            sums[k] = sumRing.data() + k * (size_t)width;
+            horizontal<3, false>(&rows[k]->r, width, sums[k]); // Outside rows arrive as zero rows
+        }
+        vertical(sums[0], sums[1], sums[2], width, InterleavedLayout::Writer::Line{out});
+    }
+
+    // Layout-generic kernel (intensity = channel 0). A ring of three rows of
+    // horizontal sums slides down the frame, so every input row is summed once.
+    // Padded layouts supply the rows and samples around the frame from their halo;
+    // packed RGB frames are zero-padded.
+    template <typename In, typename Out>
+    void convolve(const typename In::Frame* src, typename Out::Frame* dest) {
+        typename In::Reader in(src);
+        typename Out::Writer out(dest);
+        int w = src->getWidth(), h = src->getHeight();
+        sumRing.resize(3 * (size_t)w);
+        uint16_t* sums[3]; // Row y's sums live in sums[(y + 3) % 3] (y >= -1)
+        for (int k = 0; k < 3; k++) sums[k] = sumRing.data() + k * (size_t)w;
+
+        auto load = [&](int y, uint16_t* dst) {
+            if (!In::HAS_HALO && (y < 0 || y >= h)) memset(dst, 0, (size_t)w * sizeof(uint16_t));
+            else horizontal<In::STEP, In::HAS_HALO>(in.row(0, y), w, dst);
+        };
+        load(-1, sums[2]);
+        load(0, sums[0]);
+        for (int y = 0; y < h; y++) {
+            load(y + 1, sums[(y + 1) % 3]); // Replaces row y - 2
+            vertical(sums[(y + 2) % 3], sums[y % 3], sums[(y + 1) % 3], w, out.line(y));
+        }
+    }
+
+    bool supportsGray() override { return true; }
+
+    void applyGray(GrayImage* src, GrayImage* dest) override {
+        convolve<GrayLayout, GrayLayout>(src, dest);
+    }
+
+    bool supportsPlanar() override { return true; }
+
+    void applyPlanar(PlanarImage* src, PlanarImage* dest) override {
+        convolve<PlanarLayout, PlanarLayout>(src, dest);
+    }
+};
+
+// --- STAGE 3: SOBEL EDGE DETECTION ---
+class SobelFilter : public Filter {
+public:
+    string getName() override { return "Sobel Edge Detector"; }
+    
+    void apply(ImageView src, ImageView dest) override {
+        // Only interior pixels are written, so every neighbour read is inside the frame
+        gradient<InterleavedLayout, InterleavedLayout>(&src, &dest);
+    }
+
+    bool supportsRows() override { return true; }
+
+    void applyRow(const Pixel* const rows[3], Pixel* out, int width, int y, int height) override {
+        if (y < 1 || y >= height - 1) return; // Border rows are not written (same as apply)
+        int gx[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
+        int gy[3][3] = {{-1, -2, -1}, {0, 0, 0}, {1, 2, 1}};
+
+        for (int x = 1; x < width - 1; x++) {
+            int sumX = 0, sumY = 0;
+            for (int i = 0; i < 3; i++) {
+                for (int j = -1; j <= 1; j++) {
+                    int val = rows[i][x + j].r;
+                    sumX += val * gx[i][j+1];
+                    sumY += val * gy[i][j+1];
+                }
+            }
+            uint8_t final = HardwareMath::clamp(abs(sumX) + abs(sumY));
+            out[x] = {final, final, final};
+        }
+    }
+
+    bool writesAllPixels() override { return false; } // Border ring is skipped
+
+    // Layout-generic kernel (intensity = channel 0); interior pixels only
+    template <typename In, typename Out>
+    static void gradient(const typename In::Frame* src, typename Out::Frame* dest) {
+        const int S = In::STEP;
+        typename In::Reader in(src);
+        typename Out::Writer out(dest);
+        int w = src->getWidth(), h = src->getHeight();
+        for (int y = 1; y < h - 1; y++) {
+            const uint8_t* up = in.row(0, y - 1);
+            const uint8_t* mid = in.row(0, y);
+            const uint8_t* down = in.row(0, y + 1);
+            auto line = out.line(y);
+            for (int x = 1; x < w - 1; x++) {
+                int l = (x - 1) * S, c = x * S, r = (x + 1) * S;
+                // Gx = {-1,0,1},{-2,0,2},{-1,0,1}   Gy = {-1,-2,-1},{0,0,0},{1,2,1}
+                int sumX = (up[r] - up[l]) + (mid[r] - mid[l]) * 2 + (down[r] - down[l]);
+                int sumY = (down[l] + down[c] * 2 + down[r]) - (up[l] + up[c] * 2 + up[r]);
+                // Approximate magnitude |Gx| + |Gy|: no sqrt, which is expensive in hardware
+                line(x, HardwareMath::clamp(abs(sumX) + abs(sumY)));
+            }
+        }
+    }
+
+    bool supportsGray() override { return true; }
+
+    void applyGray(GrayImage* src, GrayImage* dest) override {
+        gradient<GrayLayout, GrayLayout>(src, dest);
+    }
+
+    bool supportsPlanar() override { return true; }
+
+    void applyPlanar(PlanarImage* src, PlanarImage* dest) override {
+        gradient<PlanarLayout, PlanarLayout>(src, dest);
+    }
+};
+
+// --- STAGES 1-3 FUSED: GRAYSCALE + GAUSSIAN BLUR + SOBEL ---
+// One sweep over the frame with rolling row buffers (three grayscale rows and three
+// blurred rows) instead of two intermediate frames. Bit-exact with the separate
+// stages, edges included: Sobel leaves the border ring alone, so it keeps the
+// grayscale output, and frames less than 3 pixels wide or high stay plain grayscale.
+class FusedEdgeFilter : public Filter {
+    vector<uint8_t> grayRing; // 3 rows of width + 2 (one padding sample on each side)
+    vector<uint16_t> sumRing; // 3 rows of width (horizontal blur sums, see BlurFilter)
+    vector<uint8_t> blurRing; // 3 rows of width
+
+    // Grayscale of row y into out[-1..w]. Padded layouts supply the samples around
+    // the frame (their halo follows the border mode); packed RGB pads with zeros.
+    template <typename In>
+    static void grayRow(const typename In::Reader& in, int y, int w, int h, uint8_t* out) {
+        if constexpr (is_same_v<In, GrayLayout>) {
+            memcpy(out - 1, in.row(0, y) - 1, (size_t)w + 2); // Already gray (incl. the halo)
+            return;
+        }
+        const int S = In::STEP;
+        int first = 0, end = w;
+        if (In::HAS_HALO) {
+            first = -1;
+            end = w + 1;
+        } else {
+            out[-1] = out[w] = 0;
+            if (y < 0 || y >= h) {
+                memset(out, 0, (size_t)w);
+                return;
+            }
+        }
+        const uint8_t* r = in.row(0, y);
+        const uint8_t* g = in.row(1, y);
+        const uint8_t* b = in.row(2, y);
+        for (int x = first; x < end; x++) {
+            out[x] = HardwareMath::clamp((r[x * S] * 77 + g[x * S] * 150 + b[x * S] * 29) >> 8);
+        }
+    }
+
+    // Sobel on three blurred rows; the first and last pixel keep the grayscale value
+    template <typename Line>
+    static void edgeRow(const uint8_t* up, const uint8_t* mid, const uint8_t* down, const uint8_t* gray,
+                        int w, Line line) {
+        line(0, gray[0]);
+        for (int x = 1; x < w - 1; x++) {
+            int sumX = (up[x+1] - up[x-1]) + (mid[x+1] - mid[x-1]) * 2 + (down[x+1] - down[x-1]);
+            int sumY = (down[x-1] + down[x] * 2 + down[x+1]) - (up[x-1] + up[x] * 2 + up[x+1]);
+            line(x, HardwareMath::clamp(abs(sumX) + abs(sumY)));
+        }
+        line(w - 1, gray[w - 1]);
+    }
+
+    template <typename Line>
+    static void copyRow(const uint8_t* gray, int w, Line line) {
+        for (int x = 0; x < w; x++) line(x, gray[x]);
+    }
+
+    template <typename In, typename Out>
+    void sweep(const typename In::Frame* src, typename Out::Frame* dest) {
+        typename In::Reader in(src);
+        typename Out::Writer out(dest);
+        int w = src->getWidth(), h = src->getHeight();
+        if (w <= 0 || h <= 0) return;
+        size_t pitch = (size_t)w + 2;
+        grayRing.resize(3 * pitch);
+        sumRing.resize(3 * (size_t)w);
+        blurRing.resize(3 * (size_t)w);
+        // Row y lives in gray[(y + 3) % 3] and sums[(y + 3) % 3] (y >= -1), blurred row y in blur[y % 3]
+        uint8_t* gray[3];
+        uint16_t* sums[3];
+        uint8_t* blur[3];
+        for (int i = 0; i < 3; i++) {
+            gray[i] = grayRing.data() + i * pitch + 1;
+            sums[i] = sumRing.data() + i * (size_t)w;
+            blur[i] = blurRing.data() + i * (size_t)w;
+        }
+
+        // Each gray row is summed horizontally once, as it enters the ring
+        auto load = [&](int y, int slot) {
+            grayRow<In>(in, y, w, h, gray[slot]);
+            BlurFilter::horizontal<1, true>(gray[slot], w, sums[slot]);
+        };
+        load(-1, 2);
+        load(0, 0);
+        for (int y = 0; y < h; y++) {
+            load(y + 1, (y + 1) % 3); // Replaces row y - 2
+            BlurFilter::vertical(sums[(y + 2) % 3], sums[y % 3], sums[(y + 1) % 3], w,
+                                 GrayLayout::Writer::Line{blur[y % 3]});
+
+            // Row y - 1 is complete: its blurred neighbours y - 2 and y are in the ring
+            int done = y - 1;
+            if (done < 0) continue;
+            if (done == 0 || w < 3) copyRow(gray[done % 3], w, out.line(done));
+            else edgeRow(blur[(done + 2) % 3], blur[done % 3], blur[y % 3], gray[done % 3], w, out.line(done));
+        }
+        if (h > 0) copyRow(gray[(h - 1) % 3], w, out.line(h - 1)); // Bottom row (or the only row)
+    }
+
+public:
+    string getName() override { return "Fused Edge Detector (Grayscale + Blur + Sobel)"; }
+    int getRadius() override { return 2; }
+
+    void apply(ImageView src, ImageView dest) override {
+        sweep<InterleavedLayout, InterleavedLayout>(&src, &dest);
+    }
+
+    bool outputsGray() override { return true; }
+
+    void applyToGray(ImageView src, GrayImage* dest) override {
+        sweep<InterleavedLayout, GrayLayout>(&src, dest);
+    }
+
+    bool supportsPlanar() override { return true; }
+
+    void applyPlanar(PlanarImage* src, PlanarImage* dest) override {
+        sweep<PlanarLayout, PlanarLayout>(src, dest);
+    }
+
+    void applyPlanarToGray(PlanarImage* src, GrayImage* dest) override {
+        sweep<PlanarLayout, GrayLayout>(src, dest);
+    }
+
+    // Gray8 input (e.g. a video's luma plane) is its own grayscale: only blur + Sobel run
+    bool supportsGray() override { return true; }
+
+    void applyGray(GrayImage* src, GrayImage* dest) override {
+        sweep<GrayLayout, GrayLayout>(src, dest);
+    }
+};
+
+// ============================================================
+// MODULE 6: DEBUG DUMPS (Policy + Background Disk Channel)
+// ============================================================
+// Runtime switch deciding which stage outputs are dumped and in which format.
+// Spec string (CLI '--dump <spec>' or environment variable FPGA_DUMP):
+//   off          no dumps at all (no copies, no writer thread)
+//   all          every stage of every frame (default)
+//   every:N      every stage of every N-th frame
+//   changed      only stages whose output checksum differs from the previous frame
+// Append ",binary" to write compact P6 files instead of P3 text (e.g. "every:10,binary"),
+// or ",qoi" for lossless QOI-compressed dumps (debug_stage_N.qoi).
+class DumpPolicy {
+public:
+    enum class Mode { Off, All, EveryNth, OnChange };
+    enum class Format { Text, Binary, QOI };
+
+private:
+    Mode mode = Mode::All;
+    int interval = 1;
+    Format format = Format::Text;
+
+    mutex lock;                       // Policies are shared by concurrent pipelines
+    long long frameCounter = 0;
+    map<int, uint64_t> lastChecksum;  // Stage number -> checksum of its last output
+
+public:
+    // Parses a spec string; returns false (policy unchanged) if it is invalid
+    bool configure(const string& spec) {
+        Mode newMode = Mode::All;
+        int newInterval = 1;
+        Format newFormat = Format::Text;
+
+        size_t start = 0;
+        while (start <= spec.size()) {
+            size_t comma = spec.find(',', start);
+            string token = spec.substr(start, comma == string::npos ? string::npos : comma - start);
+            if (token == "off") newMode = Mode::Off;
+            else if (token == "all") newMode = Mode::All;
+            else if (token == "changed") newMode = Mode::OnChange;
+            else if (token == "binary") newFormat = Format::Binary;
+            else if (token == "qoi") newFormat = Format::QOI;
+            else if (token.rfind("every:", 0) == 0) {
+                newMode = Mode::EveryNth;
+                newInterval = atoi(token.c_str() + 6);
+                if (newInterval <= 0) return false;
+            } else {
+                return false;
+            }
+            if (comma == string::npos) break;
+            start = comma + 1;
+        }
+
+        lock_guard<mutex> guard(lock);
+        mode = newMode;
+        interval = newInterval;
+        format = newFormat;
+        frameCounter = 0;
+        lastChecksum.clear();
+        return true;
+    }
+
+    // Process-wide policy, initialised from FPGA_DUMP on first use
+    static DumpPolicy& global() {
+        static DumpPolicy policy = [] {
+            DumpPolicy p;
+            const char* env = getenv("FPGA_DUMP");
+            if (env && !p.configure(env)) {
+                cerr << "[WARNING] Ignoring invalid FPGA_DUMP='" << env << "'" << endl;
+            }
+            return p;
+        }();
+        return policy;
+    }
+
+    DumpPolicy() = default;
+    DumpPolicy(const DumpPolicy& other)
+        : mode(other.mode), interval(other.interval), format(other.format) {}
+
+    bool isEnabled() const { return mode != Mode::Off; }
+    Format getFormat() const { return format; }
+    string extension() const { return format == Format::QOI ? ".qoi" : ".ppm"; }
+
+    // Called once per frame; returns true if this frame's stages may be dumped
+    bool beginFrame() {
+        if (mode == Mode::Off) return false;
+        lock_guard<mutex> guard(lock);
+        long long frame = frameCounter++;
+        return mode != Mode::EveryNth || frame % interval == 0;
+    }
+
+    // Decides whether one stage output of a sampled frame is written
+    template <typename Frame>
+    bool shouldDump(int stage, const Frame* frame) {
+        if (mode != Mode::OnChange) return true;
+
+        uint64_t sum = checksum(frame);
+        lock_guard<mutex> guard(lock);
+        auto it = lastChecksum.find(stage);
+        bool changed = (it == lastChecksum.end() || it->second != sum);
+        lastChecksum[stage] = sum;
+        return changed;
+    }
+
+    // FNV-1a hash of the frame geometry and pixel memory (row padding and halos are skipped)
+    struct Fnv1a {
+        uint64_t hash = 1469598103934665603ull;
+        void mix(const void* bytes, size_t count) {
+            const uint8_t* p = static_cast<const uint8_t*>(bytes);
+            for (size_t i = 0; i < count; i++) hash = (hash ^ p[i]) * 1099511628211ull;
+        }
+        template <typename Frame>
+        explicit Fnv1a(const Frame* frame) {
+            int dims[2] = {frame->getWidth(), frame->getHeight()};
+            mix(dims, sizeof(dims));
+        }
+    };
+
+    static uint64_t checksum(const Image* frame) {
+        Fnv1a fnv(frame);
+        fnv.mix(frame->getData(), (size_t)frame->getWidth() * frame->getHeight() * sizeof(Pixel));
+        return fnv.hash;
+    }
+
+    static uint64_t checksum(const GrayImage* frame) {
+        Fnv1a fnv(frame);
+        for (int y = 0; y < frame->getHeight(); y++) fnv.mix(frame->row(y), frame->getWidth());
+        return fnv.hash;
+    }
+
+    static uint64_t checksum(const PlanarImage* frame) {
+        Fnv1a fnv(frame);
+        for (int c = 0; c < 3; c++) {
+            const GrayImage& plane = frame->getPlane(c);
+            for (int y = 0; y < plane.getHeight(); y++) fnv.mix(plane.row(y), plane.getWidth());
+        }
+        return fnv.hash;
+    }
+};
+
+// Writes debug frames on a dedicated thread so the pipeline never waits for the disk.
+// Each submitted frame is copied into a pooled snapshot buffer; when every buffer is
+// still queued for writing, submit() blocks (backpressure) instead of growing memory.
+class DebugDumpWriter {
+    struct Job {
+        unique_ptr<Image> snapshot;
+        string filename;
+        DumpPolicy::Format format;
+    };
+
+    vector<unique_ptr<Image>> freeBuffers; // Snapshot pool (ready for reuse)
+    deque<Job> queue;             // Frames waiting to be written
+    size_t totalBuffers;          // Pool size = maximum frames in flight
+    size_t created = 0;
+    int busy = 0;                 // Jobs taken by the worker but not finished
+    bool stopping = false;
+
+    mutex lock;
+    condition_variable workReady;  // Signals the worker
+    condition_variable bufferFree; // Signals submit() / flush()
+    thread worker;
+
+    void run() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            workReady.wait(guard, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return; // Stopping and fully drained
+
+            Job job = move(queue.front());
+            queue.pop_front();
+            busy++;
+            guard.unlock();
+
+            switch (job.format) {
+                case DumpPolicy::Format::Binary: IOHandler::savePPMBinary(job.snapshot.get(), job.filename); break;
+                case DumpPolicy::Format::QOI:    IOHandler::saveQOI(job.snapshot.get(), job.filename); break;
+                default:                         IOHandler::savePPM(job.snapshot.get(), job.filename); break;
+            }
+            Logger::hardwareLog("Debug frame saved: " + job.filename);
+
+            guard.lock();
+            busy--;
+            freeBuffers.push_back(move(job.snapshot));
+            bufferFree.notify_all();
+        }
+    }
+
+public:
+    explicit DebugDumpWriter(size_t poolSize = 2) : totalBuffers(max<size_t>(1, poolSize)) {
+        worker = thread(&DebugDumpWriter::run, this);
+    }
+
+    ~DebugDumpWriter() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        workReady.notify_all();
+        worker.join();
+    }
+
+    // Snapshots 'frame' and queues it for writing. Blocks only if the pool is exhausted.
+    void submit(const Image* frame, const string& filename,
+                DumpPolicy::Format format = DumpPolicy::Format::Text) {
+        unique_ptr<Image> snapshot = acquireSnapshot(frame->getWidth(), frame->getHeight());
+        memcpy(snapshot->getData(), frame->getData(), (size_t)frame->getWidth() * frame->getHeight() * sizeof(Pixel));
+        enqueue(move(snapshot), filename, format);
+    }
+
+    // Gray8 frames are expanded to {v,v,v} while snapshotting, so dump files look the same
+    void submit(const GrayImage* frame, const string& filename,
+                DumpPolicy::Format format = DumpPolicy::Format::Text) {
+        unique_ptr<Image> snapshot = acquireSnapshot(frame->getWidth(), frame->getHeight());
+        frame->toInterleaved(snapshot.get());
+        enqueue(move(snapshot), filename, format);
+    }
+
+    // Planar frames are interleaved while snapshotting
+    void submit(const PlanarImage* frame, const string& filename,
+                DumpPolicy::Format format = DumpPolicy::Format::Text) {
+        unique_ptr<Image> snapshot = acquireSnapshot(frame->getWidth(), frame->getHeight());
+        frame->toInterleaved(snapshot.get());
+        enqueue(move(snapshot), filename, format);
+    }
+
+    // Waits until every queued frame is on disk
+    void flush() {
+        unique_lock<mutex> guard(lock);
+        bufferFree.wait(guard, [this] { return queue.empty() && busy == 0; });
+    }
+
+private:
+    // Pooled w x h snapshot buffer
+    unique_ptr<Image> acquireSnapshot(int w, int h) {
+        unique_ptr<Image> snapshot;
+        {
+            unique_lock<mutex> guard(lock);
+            if (freeBuffers.empty() && created < totalBuffers) {
+                created++;
+            } else {
+                bufferFree.wait(guard, [this] { return !freeBuffers.empty(); });
+                snapshot = move(freeBuffers.back());
+                freeBuffers.pop_back();
+            }
+        }
+
+        if (!snapshot || snapshot->getWidth() != w || snapshot->getHeight() != h) {
+            snapshot = make_unique<Image>(w, h);
+        }
+        return snapshot;
+    }
+
+    void enqueue(unique_ptr<Image> snapshot, const string& filename, DumpPolicy::Format format) {
+        {
+            lock_guard<mutex> guard(lock);
+            queue.push_back({move(snapshot), filename, format});
+        }
+        workReady.notify_one();
+    }
+};
+
+// ============================================================
+// MODULE 7: PIPELINE MANAGER
+// ============================================================
+class Pipeline {
+    vector<unique_ptr<Filter>> stages;
+    unique_ptr<Image> workingBuffer; // Holds the frame between stages (or the moved-in input)
+    unique_ptr<Image> backBuffer;    // Second ping-pong buffer, kept for the next frame
+    ImageView source;                // Current input: borrowed frame or region, or workingBuffer when moved in
+    Image* sourceFrame = nullptr;    // The borrowed frame, when 'source' views all of one
+    bool resultInSource = false;     // Input is borrowed and no stage has run on it yet
+    bool grayInput = false;          // Input was supplied as Gray8 (graySlot)
+    unique_ptr<Image> mappedInput;   // Moved-in mapped frame, kept alive while it is read in place
+    unique_ptr<PlanarImage> planarWorking; // Planar ping-pong pair (FrameLayout::Planar)
+    unique_ptr<PlanarImage> planarBack;
+    unique_ptr<GrayImage> grayWorking; // Gray8 ping-pong pair, used after the grayscale stage
+    unique_ptr<GrayImage> grayBack;
+
+    // Where the current frame lives; anything but Interleaved means workingBuffer is stale
+    enum class Held { Interleaved, Planar, Gray };
+    Held held = Held::Interleaved;
+    FrameLayout layout = defaultLayout;
+    BorderMode border = defaultBorder;
+    size_t blockBytes = defaultBlockBytes; // Cache-blocked working set per tile; 0 runs whole frames
+    DumpPolicy* dumpPolicy = &DumpPolicy::global();
+    unique_ptr<DebugDumpWriter> dumpWriter; // Started on the first dump only
+    string debugPrefix;                     // Prepended to debug dump file names
+
+    // Keeps 'buffer' when it already has the frame size, so a video reuses the same two frames
+    template <typename Frame>
+    static void sizedBuffer(unique_ptr<Frame>& buffer, int w, int h) {
+        if (!buffer || buffer->getWidth() != w || buffer->getHeight() != h) {
+            buffer = make_unique<Frame>(w, h);
+        }
+    }
+
+    // Stage 'i' may write Gray8 when its output is gray, every later stage runs on
+    // Gray8, and the next stage (if any) overwrites every pixel of the buffer it
+    // writes (that buffer would otherwise show the RGB frame from before stage 'i').
+    bool switchesToGray(size_t i) {
+        if (!stages[i]->outputsGray()) return false;
+        if (i + 1 < stages.size() && !stages[i + 1]->writesAllPixels()) return false;
+        for (size_t j = i + 1; j < stages.size(); j++) {
+            if (!stages[j]->supportsGray()) return false;
+        }
+        return true;
+    }
+
+    // Planar execution needs every stage up to the Gray8 switch to have planar kernels.
+    // Replicate/reflect borders live in the halo of padded frames, so they imply planar.
+    bool runsPlanar() {
+        bool wanted = (layout == FrameLayout::Planar || border != BorderMode::Zero);
+        if (!wanted || stages.empty()) return false;
+        for (size_t i = 0; i < stages.size(); i++) {
+            if (!stages[i]->supportsPlanar()) return false;
+            if (switchesToGray(i)) return true;
+        }
+        return true;
+    }
+
+    // Frame the next interleaved stage reads: the borrowed input until a stage has run
+    ImageView current() { return resultInSource ? source : ImageView(workingBuffer.get()); }
+
+    template <typename Frame>
+    void dumpStage(int step, const Frame* frame, bool dumpFrame) {
+        if (dumpFrame && dumpPolicy->shouldDump(step, frame)) {
+            if (!dumpWriter) dumpWriter = make_unique<DebugDumpWriter>();
+            string filename = debugPrefix + "debug_stage_" + to_string(step) + dumpPolicy->extension();
+            dumpWriter->submit(frame, filename, dumpPolicy->getFormat());
+        }
+    }
+
+    // Runs every stage on the current input ('source'), whole frame at a time
+    void runStages(bool dumpFrame, bool trace) {
+        int w = source.getWidth(), h = source.getHeight();
+        bool borrowed = resultInSource;
+
+        held = Held::Interleaved;
+        if (grayInput) {
+            w = grayWorking->getWidth();
+            h = grayWorking->getHeight();
+            grayWorking->fillHalo(border); // Padding the first stage reads
+            held = Held::Gray;
+        } else if (runsPlanar()) {
+            // Pipeline boundary: the only RGB -> planar conversion of the run
+            sizedBuffer(planarWorking, w, h);
+            planarWorking->fromInterleaved(current());
+            planarWorking->fillHalo(border);
+            resultInSource = false;
+            held = Held::Planar;
+        }
+
+        int step = 1;
+        for (size_t i = 0; i < stages.size(); i++) {
+            Filter* filter = stages[i].get();
+            if (trace && !Logger::quiet) Logger::log("EXECUTE", "Stage " + to_string(step) + ": " + filter->getName());
+
+            if (held == Held::Gray || switchesToGray(i)) {
+                // Gray8 path: one byte per pixel from the grayscale stage on
+                sizedBuffer(grayBack, w, h);
+                if (held == Held::Gray) filter->applyGray(grayWorking.get(), grayBack.get());
+                else if (held == Held::Planar) filter->applyPlanarToGray(planarWorking.get(), grayBack.get());
+                else filter->applyToGray(current(), grayBack.get());
+
+                swap(grayWorking, grayBack);
+                grayWorking->fillHalo(border); // Padding the next stage reads
+                resultInSource = false;
+                held = Held::Gray;
+
+                dumpStage(step, grayWorking.get(), dumpFrame);
+                step++;
+                continue;
+            }
+
+            if (held == Held::Planar) {
+                sizedBuffer(planarBack, w, h);
+                filter->applyPlanar(planarWorking.get(), planarBack.get());
+
+                swap(planarWorking, planarBack);
+                planarWorking->fillHalo(border);
+
+                dumpStage(step, planarWorking.get(), dumpFrame);
+                step++;
+                continue;
+            }
+            
+            // Secondary buffer for Double Buffering (Ping-Pong buffering)
+            sizedBuffer(backBuffer, w, h);
+            if (i == 1 && borrowed && !filter->writesAllPixels()) {
+                // Pixels this stage skips keep the input frame, as if it had been copied in
+                source.copyTo(backBuffer.get());
+            }
+
+            // 1. Apply Hardware Logic
+            filter->apply(current(), backBuffer.get());
+
+            // 2. Swap Buffers (Move data to next stage)
+            swap(workingBuffer, backBuffer);
+            resultInSource = false;
+            
+            // 3. Save Intermediate Output for Debugging (written in the background)
+            dumpStage(step, workingBuffer.get(), dumpFrame);
+            
+            step++;
+        }
+    }
+
+    // Tile of about blockBytes of working set (the input plus two ping-pong buffers).
+    // Full-width strips are preferred: rows stay long for the hardware prefetcher and
+    // only the halos above and below a strip are computed twice. Frames too wide for
+    // MIN_TILE_ROWS rows in the budget are cut into narrower tiles.
+    void tileShape(int w, int& tileW, int& tileH) {
+        static const int MIN_TILE_ROWS = 16;
+        size_t perPixel = 3 + (switchesToGray(0) ? 2 : 6);
+        size_t pixels = max(blockBytes / perPixel, (size_t)1);
+        tileW = (int)min((size_t)w, max(pixels / MIN_TILE_ROWS / 64 * 64, (size_t)64));
+        tileH = (int)max(pixels / tileW, (size_t)8);
+    }
+
+    // Cache-blocked run: all stages on one tile (plus the halo) before the next tile,
+    // so intermediate results stay in cache instead of going through memory once per
+    // stage. Kept pixels equal the whole-frame result (see Tiled). Intermediate stages
+    // never exist as whole frames; only the final stage can be dumped.
+    void executeBlocked(int blockW, int blockH, bool dumpFrame) {
+        int w = source.getWidth(), h = source.getHeight();
+        int halo = haloRadius();
+        if (!Logger::quiet) {
+            for (size_t i = 0; i < stages.size(); i++) {
+                Logger::log("EXECUTE", "Stage " + to_string(i + 1) + ": " + stages[i]->getName());
+            }
+            Logger::log("EXECUTE", "Cache-blocked: " + to_string(blockW) + "x" + to_string(blockH) + " tiles ("
+                        + to_string(blockBytes / 1024) + " KB), halo " + to_string(halo) + " px");
+        }
+
+        // The tiles reuse the ping-pong buffers, so a moved-in frame is held aside
+        ImageView input = current();
+        unique_ptr<Image> ownedInput;
+        if (!resultInSource) ownedInput = move(workingBuffer);
+
+        unique_ptr<Image> rgbResult;
+        unique_ptr<GrayImage> grayResult;
+        for (int y = 0; y < h; y += blockH) {
+            int tileH = min(blockH, h - y);
+            for (int x = 0; x < w; x += blockW) {
+                int tileW = min(blockW, w - x);
+
+                // Input region: the tile plus the halo, clipped to the frame
+                int rx = max(0, x - halo), ry = max(0, y - halo);
+                int rw = min(w, x + tileW + halo) - rx, rh = min(h, y + tileH + halo) - ry;
+                loadFrame(input.region(rx, ry, rw, rh));
+                runStages(false, false);
+
+                if (held == Held::Gray) {
+                    if (!grayResult) grayResult = make_unique<GrayImage>(w, h);
+                    for (int r = 0; r < tileH; r++) {
+                        memcpy(grayResult->row(y + r) + x, grayWorking->row(y - ry + r) + (x - rx), (size_t)tileW);
+                    }
+                } else {
+                    if (!rgbResult) rgbResult = make_unique<Image>(w, h);
+                    ImageView(getResult()).region(x - rx, y - ry, tileW, tileH)
+                        .copyTo(ImageView(rgbResult.get()).region(x, y, tileW, tileH));
+                }
+            }
+        }
+
+        // The held-aside input becomes the spare ping-pong buffer, as after a whole-frame run
+        source = input;
+        if (ownedInput) backBuffer = move(ownedInput);
+        if (grayResult) {
+            grayWorking = move(grayResult);
+            grayWorking->fillHalo(border);
+            held = Held::Gray;
+            dumpStage((int)stages.size(), grayWorking.get(), dumpFrame);
+        } else {
+            workingBuffer = move(rgbResult);
+            held = Held::Interleaved;
+            dumpStage((int)stages.size(), workingBuffer.get(), dumpFrame);
+        }
+        resultInSource = false;
+    }
+
+public:
+    // Settings of new pipelines (set once from the command line)
+    static inline FrameLayout defaultLayout = FrameLayout::Interleaved;
+    // Edge handling of the 3x3 stages. Packed RGB frames have no halo and always
+    // pad with zeros (Image::getPixel), so other modes run the frame planar.
+    static inline BorderMode defaultBorder = BorderMode::Zero;
+    static inline size_t defaultBlockBytes = 0;
+
+    // Frames are supplied later with loadFrame() (video streams)
+    Pipeline() {}
+
+    // Borrows 'input' (read in place by the first stage, never written, never copied)
+    explicit Pipeline(Image* input) {
+        loadFrame(input);
+    }
+
+    // Takes ownership of 'input'; its memory becomes the first ping-pong buffer
+    explicit Pipeline(Image&& input) {
+        loadFrame(move(input));
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Loads the next input frame by borrowing it. 'input' stays owned by the caller
+    // and must outlive the run. Mapped (read-only) frames are borrowed the same way.
+    void loadFrame(Image* input) {
+        loadFrame(ImageView(input));
+        sourceFrame = input;
+    }
+
+    // Loads a region of a larger frame (e.g. a region of interest) by borrowing it.
+    // The first stage reads the region in place; only the region is processed.
+    void loadFrame(ImageView input) {
+        source = input;
+        sourceFrame = nullptr;
+        resultInSource = true;
+        grayInput = false;
+        held = Held::Interleaved;
+    }
+
+    // Loads the next input frame by taking it over (no allocation, no copy)
+    void loadFrame(Image&& input) {
+        if (input.isReadOnly()) {
+            // A mapped frame cannot serve as a ping-pong buffer; keep it alive and read it in place
+            workingBuffer.reset();
+            mappedInput = make_unique<Image>(move(input));
+            loadFrame(mappedInput.get());
+            return;
+        }
+        mappedInput.reset(); // Unmaps a frame moved in for an earlier run
+        workingBuffer = make_unique<Image>(move(input));
+        source = workingBuffer.get();
+        sourceFrame = nullptr;
+        resultInSource = false;
+        grayInput = false;
+        held = Held::Interleaved;
+    }
+
+    // Input buffer for the next w x h frame, so readers can decode straight into
+    // pipeline memory instead of going through a separate frame + copy
+    Image* frameSlot(int w, int h) {
+        sizedBuffer(workingBuffer, w, h);
+        source = workingBuffer.get();
+        sourceFrame = nullptr;
+        resultInSource = false;
+        grayInput = false;
+        held = Held::Interleaved;
+        return workingBuffer.get();
+    }
+
+    // Gray8 input buffer for the next w x h frame. Gray input (e.g. a video's luma
+    // plane) is already grayscale, so every stage runs on Gray8 and the frame never
+    // exists as RGB. Returns nullptr unless every stage has a Gray8 kernel.
+    GrayImage* graySlot(int w, int h) {
+        for (auto& f : stages) {
+            if (!f->supportsGray()) return nullptr;
+        }
+        sizedBuffer(grayWorking, w, h);
+        grayInput = true;
+        resultInSource = false;
+        held = Held::Gray;
+        return grayWorking.get();
+    }
+
+    // Takes ownership of 'filter'
+    void addStage(Filter* filter) {
+        stages.emplace_back(filter);
+    }
+
+    // Border width within which a partial frame (tile) differs from a whole-frame run
+    int haloRadius() {
+        int halo = 0;
+        for (auto& f : stages) halo += f->getRadius();
+        return halo;
+    }
+
+    // Half of the L2 cache, leaving room for the kernels' other data
+    static size_t l2Budget() {
+        long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if (l2 <= 0) l2 = 1 << 20; // Unknown: assume 1 MB
+        return (size_t)l2 / 2;
+    }
+
+    // Overrides the process-wide debug dump policy (not owned)
+    void setDumpPolicy(DumpPolicy* policy) { dumpPolicy = policy; }
+
+    // Keeps dumps of concurrent pipelines apart (e.g. "out/frame01_")
+    void setDebugPrefix(const string& prefix) { debugPrefix = prefix; }
+
+    // MAIN EXECUTION LOGIC
+    void execute() {
+        // Log messages are only built when logging is on (quiet batch and video runs
+        // call this once per frame)
+        if (!Logger::quiet) {
+            Logger::log("CONTROL", "Initializing Pipeline...");
+            Logger::separator();
+        }
+
+        bool dumpFrame = dumpPolicy->beginFrame();
+
+        int w = source.getWidth(), h = source.getHeight();
+        int blockW = w, blockH = h;
+        if (blockBytes > 0 && !stages.empty() && !grayInput) tileShape(w, blockW, blockH);
+        if (blockW < w || blockH < h) {
+            executeBlocked(blockW, blockH, dumpFrame);
+        } else {
+            runStages(dumpFrame, true);
+        }
+        Logger::separator();
+    }
+
+    // Final frame as packed RGB (the AoS layout used for I/O). Gray8 and planar
+    // results are converted on first use, at the pipeline boundary.
+    Image* getResult() {
+        if (held == Held::Gray) {
+            sizedBuffer(workingBuffer, grayWorking->getWidth(), grayWorking->getHeight());
+            grayWorking->toInterleaved(workingBuffer.get());
+        } else if (held == Held::Planar) {
+            sizedBuffer(workingBuffer, planarWorking->getWidth(), planarWorking->getHeight());
+            planarWorking->toInterleaved(workingBuffer.get());
+        }
+        if (held != Held::Interleaved) {
+            held = Held::Interleaved;
+            resultInSource = false;
+        }
+        if (resultInSource && !sourceFrame) {
+            // No stage ran on a borrowed region: the result is a copy of it
+            sizedBuffer(workingBuffer, source.getWidth(), source.getHeight());
+            source.copyTo(workingBuffer.get());
+            resultInSource = false;
+        }
+        return resultInSource ? sourceFrame : workingBuffer.get();
+    }
+
+    // Final frame as Gray8, or nullptr when the last stage did not run on Gray8
+    GrayImage* getGrayResult() { return held == Held::Gray ? grayWorking.get() : nullptr; }
+
+    // Writes the final frame; Gray8 results go to .pgm without the RGB expansion
+    void saveResult(const string& filename) {
+        if (held == Held::Gray && filesystem::path(filename).extension() == ".pgm") {
+            IOHandler::savePGM(grayWorking.get(), filename);
+        } else {
+            IOHandler::saveImage(getResult(), filename);
+        }
+    }
+
+    // Blocks until all debug frames of the last run are written
+    void flushDebugDumps() {
+        if (dumpWriter) dumpWriter->flush();
+    }
+};
+
+// Frame pipelines run the standard chain as one fused stage (--stages separate
+// brings back the three stages, e.g. for per-stage debug dumps)
+inline bool fuseDefaultStages = true;
+
+// Standard processing chain: Grayscale -> Gaussian Blur -> Sobel.
+// Streaming execution always uses the separate stages: its row interface covers
+// one 3x3 neighbourhood per stage.
+template <typename PipelineType>
+void addDefaultStages(PipelineType& pipe) {
+    if constexpr (is_same_v<PipelineType, Pipeline>) {
+        if (fuseDefaultStages) {
+            pipe.addStage(new FusedEdgeFilter());
+            return;
+        }
+    }
+    pipe.addStage(new GrayscaleFilter());
+    pipe.addStage(new BlurFilter());
+    pipe.addStage(new SobelFilter());
+}
+
+// ============================================================
+// MODULE 8: STREAMING EXECUTION (Line Buffers)
+// ============================================================
+// Rows flow from the file through every stage and out to the writer, the way
+// pixels stream through an FPGA. Each stage keeps a small ring of rows (its
+// line buffer) instead of a full frame, so memory is O(width), not O(width*height).
+
+// Reads a PNM file one row at a time (P3 text, P6 binary RGB, P5 binary gray)
+class RowReader {
+    ifstream file;
+    string format;
+    int width = 0, height = 0;
+    int rowsRead = 0;
+
+    // P3: sliding text window that always holds at least 'lookahead' bytes (or the tail)
+    vector<char> window;
+    size_t begin = 0, end = 0, lookahead = 0;
+    bool eof = false;
+    bool warned = false;
+
+    vector<uint8_t> grayRow; // P5 staging row
+
+    // Moves the unread text to the front and reads more. A window that is still
+    // full (one token or comment spans all of it) is doubled first.
+    void fill() {
+        memmove(window.data(), window.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+        if (end == window.size()) window.resize(window.size() * 2);
+        file.read(window.data() + end, window.size() - end);
+        end += (size_t)file.gcount();
+        if (!file) eof = true;
+    }
+
+    void refill() {
+        if (eof || end - begin >= lookahead) return;
+        fill();
+    }
+
+public:
+    bool open(const string& filename) {
+        file.open(filename, ios::binary);
+        if (!file) {
+            cerr << "[ERROR] File not found!" << endl;
+            return false;
+        }
+        int maxVal;
+        file >> format;
+        if ((format != "P3" && format != "P5" && format != "P6") ||
+            !IOHandler::readHeader(file, width, height, maxVal) || maxVal > 255) {
+            cerr << "[ERROR] Streaming needs an 8-bit PPM (P3/P6) or PGM (P5): " << filename << endl;
+            return false;
+        }
+
+        if (format == "P3") {
+            // A text row is at most 12 bytes per pixel; keep extra room for comments/whitespace
+            lookahead = (size_t)width * 12 + (64u << 10);
+            window.resize(lookahead * 2);
+        } else {
+            file.get(); // Single whitespace byte before the binary payload
+            if (format == "P5") grayRow.resize(width);
+        }
+        Logger::log("DMA_READ", "Streaming file: " + filename);
+        Logger::hardwareLog("Resolution detected: " + to_string(width) + "x" + to_string(height) + " (" + format + ")");
+        return true;
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Reads the next row into 'row' (width pixels). Missing data is zero-filled.
+    void readRow(Pixel* row) {
+        rowsRead++;
+        size_t samples = (size_t)width * 3;
+        uint8_t* out = reinterpret_cast<uint8_t*>(row);
+        size_t got = 0;
+
+        if (format == "P3") {
+            refill();
+            int v;
+            while (got < samples) {
+                PNMScanner scanner(window.data() + begin, window.data() + end);
+                const char* token = scanner.pos;
+                bool ok = true;
+                while (got < samples) {
+                    token = scanner.pos;
+                    ok = scanner.readInt(v);
+                    if (scanner.pos == scanner.end && !eof) break; // May continue past the window
+                    if (!ok) break;
+                    out[got++] = (uint8_t)v;
+                }
+                if (scanner.pos == scanner.end && !eof) {
+                    // Row text is longer than the window: re-scan the cut token after a refill
+                    begin = (size_t)(token - window.data());
+                    fill();
+                    continue;
+                }
+                begin = (size_t)(scanner.pos - window.data());
+                break; // Row complete, end of file, or a malformed token
+            }
+        } else if (format == "P6") {
+            file.read(reinterpret_cast<char*>(out), samples);
+            got = (size_t)file.gcount();
+        } else {
+            file.read(reinterpret_cast<char*>(grayRow.data()), width);
+            for (int x = 0; x < (int)file.gcount(); x++) row[x] = {grayRow[x], grayRow[x], grayRow[x]};
+            got = (size_t)file.gcount() * 3;
+        }
+
+        if (got < samples) {
+            if (!warned) cerr << "[WARNING] Input ends early at row " << rowsRead - 1 << "; missing pixels set to 0." << endl;
+            warned = true;
+            memset(out + got, 0, samples - got);
+        }
+    }
+};
+
+// Writes a PNM file one row at a time: P3 text (byte-identical to savePPM),
+// P6 binary, or P5 gray when the name ends in ".pgm"
+class RowWriter {
+    ofstream file;
+    enum class Kind { Text, Binary, Gray } kind = Kind::Text;
+    int width = 0;
+    vector<char> line;
+
+public:
+    bool open(const string& filename, int w, int h, bool binary = false) {
+        bool pgm = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".pgm") == 0;
+        kind = pgm ? Kind::Gray : (binary ? Kind::Binary : Kind::Text);
+        width = w;
+        file.open(filename, ios::binary);
+        if (!file) {
+            cerr << "[ERROR] Cannot create " << filename << endl;
+            return false;
+        }
+        const char* magic = (kind == Kind::Text) ? "P3" : (kind == Kind::Binary ? "P6" : "P5");
+        file << magic << "\n" << w << " " << h << "\n255\n";
+        line.resize((size_t)w * 12 + 1);
+        return true;
+    }
+
+    void writeRow(const Pixel* row) {
+        if (kind == Kind::Text) {
+            char* end = IOHandler::formatP3Row(row, width, line.data());
+            file.write(line.data(), end - line.data());
+        } else if (kind == Kind::Binary) {
+            file.write(reinterpret_cast<const char*>(row), (size_t)width * sizeof(Pixel));
+        } else {
+            for (int x = 0; x < width; x++) line[x] = (char)row[x].r;
+            file.write(line.data(), width);
+        }
+    }
+};
+
+class StreamingPipeline {
+    vector<unique_ptr<Filter>> stages;
+
+    static const int RING_ROWS = 4; // Rows kept per line buffer
+
+public:
+    // Takes ownership of 'filter'
+    void addStage(Filter* filter) {
+        stages.emplace_back(filter);
+    }
+
+    // Streams the whole frame from 'reader' to 'writer'. Returns false if a stage
+    // cannot run on rows.
+    bool execute(RowReader& reader, RowWriter& writer) {
+        for (auto& f : stages) {
+            if (!f->supportsRows()) {
+                cerr << "[ERROR] Stage '" << f->getName() << "' does not support streaming." << endl;
+                return false;
+            }
+        }
+
+        int w = reader.getWidth(), h = reader.getHeight();
+        int levels = (int)stages.size() + 1; // Level 0 = source rows, level k = output of stage k
+
+        // Line buffers: RING_ROWS rows per level, indexed by row number
+        vector<Pixel> lineBuffers((size_t)levels * RING_ROWS * w);
+        vector<Pixel> zeroRow(w, Pixel{0, 0, 0});
+        vector<int> produced(levels, 0); // Rows completed per level
+
+        auto row = [&](int level, int y) {
+            return lineBuffers.data() + ((size_t)level * RING_ROWS + y % RING_ROWS) * w;
+        };
+
+        Logger::log("CONTROL", "Initializing Streaming Pipeline...");
+        Logger::hardwareLog("Line buffers: " + to_string(lineBuffers.size() * sizeof(Pixel)) + " bytes (" +
+                            to_string(levels) + " levels x " + to_string(RING_ROWS) + " rows)");
+        Logger::hardwareLog("Debug stage dumps are not produced in streaming mode");
+        Logger::separator();
+        for (size_t k = 0; k < stages.size(); k++) {
+            Logger::log("EXECUTE", "Stage " + to_string(k + 1) + ": " + stages[k]->getName() + " (streaming)");
+        }
+
+        int last = levels - 1;
+        while (produced[last] < h) {
+            // Deepest stage first: a level only runs ahead when the next one is waiting
+            // for input, so every row a stage needs is still inside its ring.
+            int k = last;
+            for (; k >= 1; k--) {
+                int y = produced[k];
+                if (y < h && produced[k - 1] >= min(y + 2, h)) break;
+            }
+
+            if (k == 0) {
+                reader.readRow(row(0, produced[0]));
+                produced[0]++;
+                if (last == 0) writer.writeRow(row(0, produced[0] - 1));
+                continue;
+            }
+
+            int y = produced[k];
+            const Pixel* window[3] = {
+                y > 0     ? row(k - 1, y - 1) : zeroRow.data(),
+                row(k - 1, y),
+                y + 1 < h ? row(k - 1, y + 1) : zeroRow.data()
+            };
+
+            // Ping-pong equivalence: in batch mode stage k writes into the buffer that
+            // holds the output of stage k-2 (the input frame for stage 2)
+            Pixel* out = row(k, y);
+            const Pixel* previous = (k >= 2) ? row(k - 2, y) : zeroRow.data();
+            memcpy(out, previous, (size_t)w * sizeof(Pixel));
+
+            stages[k - 1]->applyRow(window, out, w, y, h);
+            produced[k]++;
+            if (k == last) writer.writeRow(out);
+        }
+
+        Logger::separator();
+        return true;
+    }
+};
+
+// ============================================================
+// MODULE 9: IO_URING BACKEND (Batched Disk Transfers)
+// ============================================================
+// Minimal io_uring driver on raw system calls (no liburing dependency).
+// Many reads/writes are queued in the submission ring and handed to the kernel
+// with a single io_uring_enter() call, instead of one syscall per stream.
+// If the kernel refuses io_uring (old kernel, seccomp), transfers fall back to pread/pwrite.
+class UringIO {
+    int ringFd = -1;
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+    io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+
+    unsigned *sqHead = nullptr, *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned entries = 0;
+    vector<iovec> registered;        // Fixed buffers known to the kernel
+
+public:
+    // One disk transfer; 'result' receives bytes moved (or -errno)
+    struct Transfer {
+        int fd;
+        char* buffer;
+        size_t length;
+        off_t offset;
+        bool write;
+        long long result = 0;
+    };
+
+    explicit UringIO(unsigned depth = 64) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = (int)syscall(__NR_io_uring_setup, depth, &params);
+        if (fd < 0) return;
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) sqRingSize = cqRingSize = max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        cqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? sqRing :
+                 mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        sqes = (io_uring_sqe*)mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        ringFd = fd;
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == (io_uring_sqe*)MAP_FAILED) {
+            shutdown();
+            return;
+        }
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = (unsigned*)(sq + params.sq_off.head);
+        sqTail = (unsigned*)(sq + params.sq_off.tail);
+        sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+        sqArray = (unsigned*)(sq + params.sq_off.array);
+        cqHead = (unsigned*)(cq + params.cq_off.head);
+        cqTail = (unsigned*)(cq + params.cq_off.tail);
+        cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+        cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+        entries = params.sq_entries;
+    }
+
+    ~UringIO() { shutdown(); }
+
+    UringIO(const UringIO&) = delete;
+    UringIO& operator=(const UringIO&) = delete;
+
+    bool isReady() const { return ringFd >= 0; }
+
+    // Registers long-lived buffers (pinned once) so reads into them skip per-I/O page mapping.
+    // Replaces any previous set. Returns false if the kernel refused (e.g. RLIMIT_MEMLOCK).
+    bool registerBuffers(const vector<iovec>& buffers) {
+        if (!isReady()) return false;
+        if (!registered.empty()) {
+            syscall(__NR_io_uring_register, ringFd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+            registered.clear();
+        }
+        if (buffers.empty()) return true;
+        if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, buffers.data(), (unsigned)buffers.size()) != 0) {
+            return false;
+        }
+        registered = buffers;
+        return true;
+    }
+
+    // Index of the registered buffer containing [p, p+len), or -1
+    int fixedIndex(const char* p, size_t len) const {
+        for (size_t i = 0; i < registered.size(); i++) {
+            const char* base = static_cast<const char*>(registered[i].iov_base);
+            if (p >= base && p + len <= base + registered[i].iov_len) return (int)i;
+        }
+        return -1;
+    }
+
+    // Runs every transfer to completion. Ops are submitted in ring-sized batches;
+    // short transfers are resubmitted for the remainder.
+    void run(vector<Transfer>& transfers) {
+        for (auto& t : transfers) t.result = 0;
+        if (!isReady()) {
+            for (auto& t : transfers) runSync(t);
+            return;
+        }
+
+        vector<size_t> active;
+        for (size_t i = 0; i < transfers.size(); i++) if (transfers[i].length > 0) active.push_back(i);
+
+        while (!active.empty()) {
+            size_t batch = min<size_t>(active.size(), entries);
+            unsigned tail = *sqTail;
+            for (size_t b = 0; b < batch; b++) {
+                prepare(transfers[active[b]], active[b], tail & *sqMask);
+                tail++;
+            }
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+            // One system call submits the whole batch and waits for all of it
+            long submitted = syscall(__NR_io_uring_enter, ringFd, (unsigned)batch, (unsigned)batch,
+                                     IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (submitted > 0) reap((size_t)submitted, transfers);
+
+            if (submitted != (long)batch) {
+                // Ring refused work: finish everything with plain pread/pwrite
+                shutdown();
+                for (size_t i : active) runSync(transfers[i]);
+                return;
+            }
+
+            // Keep only transfers that still have bytes left
+            vector<size_t> next;
+            for (size_t b = 0; b < active.size(); b++) {
+                Transfer& t = transfers[active[b]];
+                if (b >= batch || (t.result >= 0 && (size_t)t.result < t.length)) next.push_back(active[b]);
+            }
+            active.swap(next);
+        }
+    }
+
+private:
+    static const size_t MAX_CHUNK = 1u << 30; // Kernel I/O length is 32-bit
+
+    // Fills one submission queue entry for the remaining part of 't'
+    void prepare(const Transfer& t, size_t id, unsigned slot) {
+        size_t pos = (size_t)t.result;
+        size_t len = min(t.length - pos, MAX_CHUNK);
+        int fixed = fixedIndex(t.buffer + pos, len);
+
+        io_uring_sqe* sqe = &sqes[slot];
+        memset(sqe, 0, sizeof(*sqe));
+        if (fixed >= 0) sqe->opcode = t.write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        else sqe->opcode = t.write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe->fd = t.fd;
+        sqe->addr = (uint64_t)(uintptr_t)(t.buffer + pos);
+        sqe->len = (unsigned)len;
+        sqe->off = (uint64_t)(t.offset + pos);
+        if (fixed >= 0) sqe->buf_index = (uint16_t)fixed;
+        sqe->user_data = id;
+        sqArray[slot] = slot;
+    }
+
+    // Collects 'count' completions into the transfer results
+    void reap(size_t count, vector<Transfer>& transfers) {
+        size_t reaped = 0;
+        while (reaped < count) {
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            if (head == tail) {
+                syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                continue;
+            }
+            for (; head != tail; head++, reaped++) {
+                io_uring_cqe* cqe = &cqes[head & *cqMask];
+                Transfer& t = transfers[cqe->user_data];
+                if (cqe->res < 0) t.result = cqe->res;
+                else if (cqe->res == 0) t.result = -EIO; // Unexpected end of file
+                else t.result += cqe->res;
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+    }
+
+    // Fallback path: plain positional I/O, continuing after 'result' bytes
+    static void runSync(Transfer& t) {
+        while (t.result >= 0 && (size_t)t.result < t.length) {
+            size_t pos = (size_t)t.result;
+            ssize_t n = t.write ? pwrite(t.fd, t.buffer + pos, t.length - pos, t.offset + pos)
+                                : pread(t.fd, t.buffer + pos, t.length - pos, t.offset + pos);
+            if (n < 0) t.result = -errno;
+            else if (n == 0) t.result = -EIO;
+            else t.result += n;
+        }
+    }
+
+    void shutdown() {
+        if (sqes != (io_uring_sqe*)MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) close(ringFd);
+        sqes = (io_uring_sqe*)MAP_FAILED;
+        sqRing = cqRing = MAP_FAILED;
+        ringFd = -1;
+        registered.clear();
+    }
+};
+
+// Collects finished files (outputs and debug dumps) from any thread and writes them
+// in batches: one io_uring submission carries the writes of every queued file.
+// Installed as IOHandler::fileSink. The queue is bounded; producers block when it is full.
+class UringBatchWriter {
+    struct PendingFile {
+        string filename;
+        vector<char> bytes;
+    };
+
+    deque<PendingFile> queue;
+    size_t maxQueued;
+    bool writing = false;
+    bool stopping = false;
+    mutex lock;
+    condition_variable workReady;
+    condition_variable spaceFree;
+    thread worker;
+
+    void run() {
+        UringIO ring(64);
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            workReady.wait(guard, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+
+            // Everything queued so far becomes one batch
+            vector<PendingFile> batch;
+            while (!queue.empty()) {
+                batch.push_back(move(queue.front()));
+                queue.pop_front();
+            }
+            writing = true;
+            guard.unlock();
+            spaceFree.notify_all();
+
+            vector<UringIO::Transfer> transfers;
+            vector<int> fds;
+            for (auto& f : batch) {
+                int fd = open(f.filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd < 0) {
+                    cerr << "[ERROR] Cannot create " << f.filename << endl;
+                    continue;
+                }
+                fds.push_back(fd);
+                transfers.push_back({fd, f.bytes.data(), f.bytes.size(), 0, true});
+            }
+            ring.run(transfers);
+            for (auto& t : transfers) {
+                if (t.result != (long long)t.length) cerr << "[ERROR] Write failed (" << t.result << ")" << endl;
+            }
+            for (int fd : fds) close(fd);
+
+            guard.lock();
+            writing = false;
+            spaceFree.notify_all();
+        }
+    }
+
+public:
+    explicit UringBatchWriter(size_t queueLimit = 64) : maxQueued(max<size_t>(1, queueLimit)) {
+        worker = thread(&UringBatchWriter::run, this);
+    }
+
+    ~UringBatchWriter() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        workReady.notify_all();
+        worker.join();
+    }
+
+    void submit(const string& filename, vector<char>&& bytes) {
+        {
+            unique_lock<mutex> guard(lock);
+            spaceFree.wait(guard, [this] { return queue.size() < maxQueued; });
+            queue.push_back({filename, move(bytes)});
+        }
+        workReady.notify_one();
+    }
+
+    // Waits until every submitted file is on disk
+    void flush() {
+        unique_lock<mutex> guard(lock);
+        spaceFree.wait(guard, [this] { return queue.empty() && !writing; });
+    }
+};
+
+// ============================================================
+// MODULE 10: BATCH PROCESSING (Frame-Level Thread Pool)
+// ============================================================
+// Fixed-size worker pool. Tasks are queued and picked up by idle workers.
+class ThreadPool {
+    vector<thread> workers;
+    deque<function<void()>> tasks;
+    mutex lock;
+    condition_variable taskReady;
+    condition_variable allDone;
+    int pending = 0; // Queued + running tasks
+    bool stopping = false;
+
+    void run() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            taskReady.wait(guard, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+
+            function<void()> task = move(tasks.front());
+            tasks.pop_front();
+            guard.unlock();
+            task();
+            guard.lock();
+
+            if (--pending == 0) allDone.notify_all();
+        }
+    }
+
+public:
+    // spreadNodes: pin worker i to NUMA node i % nodeCount, so the frames it
+    // allocates (NUMA-local pool) stay next to the cores that process them
+    explicit ThreadPool(unsigned count, bool spreadNodes = false) {
+        for (unsigned i = 0; i < max(1u, count); i++) {
+            workers.emplace_back([this, i, spreadNodes] {
+                if (spreadNodes) Numa::bindThread((int)(i % Numa::nodeCount()));
+                run();
+            });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        taskReady.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    void submit(function<void()> task) {
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.push_back(move(task));
+            pending++;
+        }
+        taskReady.notify_one();
+    }
+
+    // Blocks until every submitted task has finished
+    void wait() {
+        unique_lock<mutex> guard(lock);
+        allDone.wait(guard, [this] { return pending == 0; });
+    }
+
+    size_t size() const { return workers.size(); }
+};
+
+// Decodes upcoming frames on a dedicated I/O thread while the pipelines compute.
+// Decoded frames are handed over through a bounded queue; their buffers come from a
+// small pool and are recycled by the consumer, so steady-state decoding reuses memory
+// and the I/O thread can never run more than 'poolSize' frames ahead.
+// With io_uring enabled, every free pool slot is filled in one group: the reads of
+// all files in the group are submitted together, and binary payloads land directly
+// in the pool's (registered) frame buffers.
+class FramePrefetcher {
+public:
+    struct Frame {
+        string filename;
+        unique_ptr<Image> image; // nullptr if the file could not be decoded
+    };
+
+private:
+    vector<string> inputs;
+    size_t poolSize;
+    size_t slotsInUse = 0;       // Buffers decoded, queued or held by consumers
+    vector<unique_ptr<Image>> freeBuffers; // Recycled buffers ready for the next decode
+    deque<Frame> ready;          // Decoded frames waiting for a consumer
+    bool finished = false;       // All inputs decoded
+    bool stopping = false;
+
+    bool useUring;
+    vector<Image*> poolBuffers;      // Every live pool buffer (not owned; pinned for io_uring)
+    vector<pair<void*, size_t>> registeredRanges; // Buffers currently registered with io_uring
+    bool buffersReleased = false;                  // A pool buffer was freed since registration
+
+    mutex lock;
+    condition_variable frameReady;
+    condition_variable bufferFree;
+    thread ioThread;
+
+    void run() {
+        unique_ptr<UringIO> ring = useUring ? make_unique<UringIO>(64) : nullptr;
+        if (ring && !ring->isReady()) {
+            cerr << "[WARNING] io_uring unavailable; falling back to synchronous reads." << endl;
+        }
+
+        size_t nextInput = 0;
+        while (nextInput < inputs.size()) {
+            // Claim free pool slots: one frame at a time, or every free slot with io_uring
+            vector<unique_ptr<Image>> buffers;
+            {
+                unique_lock<mutex> guard(lock);
+                bufferFree.wait(guard, [this] { return stopping || slotsInUse < poolSize; });
+                if (stopping) break;
+                size_t group = ring ? min(poolSize - slotsInUse, inputs.size() - nextInput) : 1;
+                slotsInUse += group;
+                buffers.resize(group);
+                for (size_t i = 0; i < group && !freeBuffers.empty(); i++) {
+                    buffers[i] = move(freeBuffers.back());
+                    freeBuffers.pop_back();
+                }
+            }
+
+            vector<string> names(inputs.begin() + nextInput, inputs.begin() + nextInput + buffers.size());
+            nextInput += buffers.size();
+            vector<unique_ptr<Image>> images;
+            if (ring) {
+                images = decodeGroup(*ring, names, buffers);
+            } else {
+                Image* previous = buffers[0].get();
+                images.push_back(IOHandler::loadPPM(names[0], 0, move(buffers[0])));
+                lock_guard<mutex> guard(lock);
+                replaceBuffer(previous, images[0].get());
+            }
+
+            {
+                lock_guard<mutex> guard(lock);
+                for (size_t i = 0; i < names.size(); i++) {
+                    if (buffers[i]) freeBuffers.push_back(move(buffers[i])); // Decode failed early: keep buffer pooled
+                    if (!images[i]) slotsInUse--;
+                    ready.push_back({names[i], move(images[i])});
+                }
+            }
+            frameReady.notify_all();
+        }
+        ring.reset();
+
+        lock_guard<mutex> guard(lock);
+        finished = true;
+        frameReady.notify_all();
+    }
+
+    // Pool bookkeeping after a decode that was handed buffer 'previous' returned 'current'.
+    // A buffer the loader did not return was freed by it (resolution changed or decode
+    // failed); a new buffer joins the pool. Called with 'lock' held.
+    void replaceBuffer(Image* previous, Image* current) {
+        if (current == previous) return;
+        if (previous) {
+            poolBuffers.erase(find(poolBuffers.begin(), poolBuffers.end(), previous));
+            buffersReleased = true;
+        }
+        if (current) poolBuffers.push_back(current);
+    }
+
+    // io_uring group decode. Three batched phases:
+    //   1. probe: read the first block of every file (header)
+    //   2. payload: P6/P5 pixels straight into the frame buffers, other formats into staging memory
+    //   3. decode staged files (P3 text, QOI) and expand P5 in place
+    // Result i is the frame decoded into buffers[i] (taken over), a new Image (resolution
+    // changed) or nullptr. buffers[i] is left in place when the file failed before its decode.
+    vector<unique_ptr<Image>> decodeGroup(UringIO& ring, const vector<string>& names,
+                                          vector<unique_ptr<Image>>& buffers) {
+        const size_t PROBE = 4096;
+        size_t n = names.size();
+        vector<unique_ptr<Image>> result(n);
+        vector<int> fds(n, -1);
+        vector<size_t> sizes(n, 0);
+        vector<char> probes(n * PROBE);
+        vector<UringIO::Transfer> transfers;
+        vector<size_t> owner;
+
+        for (size_t i = 0; i < n; i++) {
+            Logger::log("DMA_READ", "Queueing file: " + names[i]);
+            struct stat st;
+            fds[i] = open(names[i].c_str(), O_RDONLY);
+            if (fds[i] < 0 || fstat(fds[i], &st) != 0) {
+                cerr << "[ERROR] File not found: " << names[i] << endl;
+                continue;
+            }
+            sizes[i] = (size_t)st.st_size;
+            transfers.push_back({fds[i], probes.data() + i * PROBE, min(sizes[i], PROBE), 0, false});
+            owner.push_back(i);
+        }
+        ring.run(transfers);
+
+        // Phase 2: plan payload reads
+        vector<vector<char>> staging(n);
+        vector<char> isGray(n, 0);
+        vector<size_t> probed(n, 0);
+        for (size_t k = 0; k < transfers.size(); k++) {
+            if (transfers[k].result > 0) probed[owner[k]] = (size_t)transfers[k].result;
+        }
+        transfers.clear();
+        owner.clear();
+
+        for (size_t i = 0; i < n; i++) {
+            if (fds[i] < 0 || probed[i] == 0) continue;
+            const char* head = probes.data() + i * PROBE;
+            int w, h, maxVal;
+            PNMScanner scanner(head + 2, head + probed[i]);
+            bool binary = probed[i] > 2 && head[0] == 'P' && (head[1] == '6' || head[1] == '5') &&
+                          scanner.readInt(w) && scanner.readInt(h) && scanner.readInt(maxVal) &&
+                          w > 0 && h > 0 && maxVal <= 255 && scanner.pos < scanner.end;
+            if (binary) {
+                size_t offset = (size_t)(scanner.pos - head) + 1;
+                size_t bytes = (size_t)w * h * (head[1] == '6' ? sizeof(Pixel) : 1);
+                if (offset + bytes > sizes[i]) {
+                    cerr << "[ERROR] Unexpected end of pixel data in " << names[i] << endl;
+                    continue;
+                }
+                Image* previous = buffers[i].get();
+                result[i] = IOHandler::frameBuffer(w, h, move(buffers[i]));
+                {
+                    lock_guard<mutex> guard(lock);
+                    replaceBuffer(previous, result[i].get());
+                }
+                isGray[i] = (head[1] == '5');
+                transfers.push_back({fds[i], reinterpret_cast<char*>(result[i]->getData()), bytes, (off_t)offset, false});
+            } else {
+                staging[i].resize(sizes[i]);
+                transfers.push_back({fds[i], staging[i].data(), sizes[i], 0, false});
+            }
+            owner.push_back(i);
+        }
+
+        // Pin the pool's frame buffers once; re-register only when the pool changes
+        vector<Image*> pinned;
+        {
+            lock_guard<mutex> guard(lock);
+            pinned = poolBuffers;
+        }
+        // Freed memory stays pinned until re-registration, so any release forces one
+        // (a new buffer at a recycled address would otherwise hit the stale pages)
+        vector<pair<void*, size_t>> ranges;
+        for (auto img : pinned) ranges.push_back({bufferRange(img).iov_base, bufferRange(img).iov_len});
+        sort(ranges.begin(), ranges.end());
+        if (buffersReleased || ranges != registeredRanges) {
+            vector<iovec> iov;
+            for (auto& r : ranges) iov.push_back({r.first, r.second});
+            registeredRanges = ring.registerBuffers(iov) ? ranges : vector<pair<void*, size_t>>();
+            buffersReleased = false;
+        }
+
+        ring.run(transfers);
+
+        // Phase 3: decode / finish
+        for (size_t k = 0; k < transfers.size(); k++) {
+            size_t i = owner[k];
+            bool ok = transfers[k].result == (long long)transfers[k].length;
+            if (!ok) {
+                cerr << "[ERROR] Read failed for " << names[i] << endl;
+                if (result[i]) buffers[i] = move(result[i]); // Already pooled: hand it back
+            } else if (!staging[i].empty()) {
+                Image* previous = buffers[i].get();
+                result[i] = IOHandler::decodeMemory(staging[i].data(), staging[i].size(), names[i], move(buffers[i]));
+                lock_guard<mutex> guard(lock);
+                replaceBuffer(previous, result[i].get());
+            } else if (isGray[i]) {
+                IOHandler::expandGray(result[i].get());
+            }
+        }
+        for (int fd : fds) if (fd >= 0) close(fd);
+        return result;
+    }
+
+    static iovec bufferRange(Image* img) {
+        return {img->getData(), (size_t)img->getWidth() * img->getHeight() * sizeof(Pixel)};
+    }
+
+public:
+    FramePrefetcher(const vector<string>& files, size_t depth, bool uring = false)
+        : inputs(files), poolSize(max<size_t>(1, depth)), useUring(uring) {
+        ioThread = thread(&FramePrefetcher::run, this);
+    }
+
+    ~FramePrefetcher() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        bufferFree.notify_all();
+        ioThread.join();
+    }
+
+    // Waits for the next decoded frame. Returns false once every input was handed out.
+    bool next(Frame& frame) {
+        unique_lock<mutex> guard(lock);
+        frameReady.wait(guard, [this] { return finished || !ready.empty(); });
+        if (ready.empty()) return false;
+        frame = move(ready.front());
+        ready.pop_front();
+        return true;
+    }
+
+    // Returns a frame buffer to the pool once the consumer is done with it
+    void recycle(unique_ptr<Image> img) {
+        if (!img) return;
+        {
+            lock_guard<mutex> guard(lock);
+            freeBuffers.push_back(move(img));
+            slotsInUse--;
+        }
+        bufferFree.notify_one();
+    }
+};
+
+// Headless multi-frame processing: one pipeline per frame, frames spread over a pool.
+// Decoding is overlapped with compute by a FramePrefetcher.
+namespace Batch {
+    // Files of a directory (sorted) or the lines of a list file
+    vector<string> collectInputs(const string& source) {
+        vector<string> inputs;
+        error_code ec;
+        if (filesystem::is_directory(source, ec)) {
+            for (const auto& entry : filesystem::directory_iterator(source, ec)) {
+                string ext = entry.path().extension().string();
+                if (entry.is_regular_file() && (ext == ".ppm" || ext == ".pgm" || ext == ".qoi")) {
+                    inputs.push_back(entry.path().string());
+                }
+            }
+            sort(inputs.begin(), inputs.end());
+        } else {
+            ifstream list(source);
+            string line;
+            while (getline(list, line)) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (!line.empty() && line[0] != '#') inputs.push_back(line);
+            }
+        }
+        return inputs;
+    }
+
+    // Per-frame file prefix: <outDir>/<input stem>_  (outputs and debug dumps)
+    string framePrefix(const string& input, const string& outDir) {
+        filesystem::path stem = filesystem::path(input).stem();
+        return (filesystem::path(outDir) / stem).string() + "_";
+    }
+
+    // useUring: batch reads through the prefetcher and batch writes through UringBatchWriter
+    int run(const string& source, const string& outDir, const string& extension, unsigned threads,
+            bool useUring = false) {
+        vector<string> inputs = collectInputs(source);
+        if (inputs.empty()) {
+            cerr << "[ERROR] No input frames found in " << source << endl;
+            return 1;
+        }
+        error_code ec;
+        filesystem::create_directories(outDir, ec);
+
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        cout << "[BATCH]      : " << inputs.size() << " frames, " << threads << " worker threads"
+             << (useUring ? ", io_uring I/O" : "") << endl;
+
+        atomic<int> done{0}, failed{0};
+        atomic<long long> pixels{0};
+        bool wasQuiet = Logger::quiet;
+        Logger::quiet = true; // Per-stage traces of concurrent frames would interleave
+
+        auto t0 = chrono::steady_clock::now();
+        {
+            UringBatchWriter* writer = nullptr;
+            if (useUring) {
+                writer = new UringBatchWriter();
+                IOHandler::fileSink = [writer](const string& name, vector<char>&& bytes) {
+                    writer->submit(name, move(bytes));
+                };
+            }
+
+            // Each worker holds one frame while the I/O thread decodes up to two more
+            // (a larger pool with io_uring, so each read group carries several files)
+            FramePrefetcher prefetcher(inputs, useUring ? threads * 2 + 8 : threads + 2, useUring);
+            ThreadPool pool(threads, FramePool::global().isNumaLocal());
+            for (unsigned t = 0; t < threads; t++) {
+                pool.submit([&]() {
+                    FramePrefetcher::Frame frame;
+                    while (prefetcher.next(frame)) {
+                        if (!frame.image) {
+                            failed++;
+                            continue;
+                        }
+                        string prefix = framePrefix(frame.filename, outDir);
+                        {
+                            Pipeline pipe(frame.image.get());
+                            addDefaultStages(pipe);
+                            pipe.setDebugPrefix(prefix);
+                            pipe.execute();
+                            pipe.saveResult(prefix + "out" + extension);
+                        }
+                        pixels += (long long)frame.image->getWidth() * frame.image->getHeight();
+                        prefetcher.recycle(move(frame.image));
+                        done++;
+                    }
+                });
+            }
+            pool.wait();
+
+            if (writer) {
+                writer->flush();
+                IOHandler::fileSink = nullptr;
+                delete writer;
+            }
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        Logger::quiet = wasQuiet;
+
+        cout << fixed << setprecision(2) << right;
+        cout << "[BATCH]      : " << done << " frames processed, " << failed << " failed, in " << seconds << " s" << endl;
+        cout << "[BATCH]      : " << done / seconds << " frames/s, " << pixels / seconds / 1e6 << " Mpix/s" << endl;
+        FramePool::global().report(cout);
+        return failed == 0 ? 0 : 1;
+    }
+}
+
+// ============================================================
+// MODULE 11: BENCHMARK (Loader Throughput)
+// ============================================================
+// Compares the reference stream-based P3 parser against the fast
+// buffered parser and reports throughput in MB/s.
+namespace Benchmark {
+    // Runs 'loader' several times and returns the best wall time in seconds
+    template <typename Loader>
+    double timeLoader(Loader loader, const string& filename, int iterations, unique_ptr<Image>& result) {
+        double best = 1e30;
+        for (int i = 0; i < iterations; i++) {
+            auto t0 = chrono::steady_clock::now();
+            unique_ptr<Image> img = loader(filename);
+            auto t1 = chrono::steady_clock::now();
+            best = min(best, chrono::duration<double>(t1 - t0).count());
+            if (i + 1 == iterations) result = move(img);
+        }
+        return best;
+    }
+
+    bool samePixels(const Image* a, const Image* b) {
+        if (!a || !b || a->getWidth() != b->getWidth() || a->getHeight() != b->getHeight()) return false;
+        size_t bytes = (size_t)a->getWidth() * a->getHeight() * sizeof(Pixel);
+        return memcmp(a->getData(), b->getData(), bytes) == 0;
+    }
+
+    int runLoaderBenchmark(const string& filename, int iterations = 5) {
+        ifstream probe(filename, ios::binary | ios::ate);
+        if (!probe) {
+            cerr << "[ERROR] File not found!" << endl;
+            return 1;
+        }
+        double megabytes = (double)probe.tellg() / (1024.0 * 1024.0);
+
+        Logger::quiet = true;
+        unique_ptr<Image> reference, fast, chunked;
+        double tStream = timeLoader(IOHandler::loadPPMStream, filename, iterations, reference);
+        double tFast = timeLoader([](const string& f) { return IOHandler::loadPPM(f, 1); }, filename, iterations, fast);
+        unsigned threads = max(2u, thread::hardware_concurrency());
+        double tChunked = timeLoader([threads](const string& f) { return IOHandler::loadPPM(f, threads); },
+                                     filename, iterations, chunked);
+        Logger::quiet = false;
+
+        cout << fixed << setprecision(2) << right;
+        cout << "P3 loader benchmark: " << filename << " (" << megabytes << " MB, best of " << iterations << ")" << endl;
+        cout << "  ifstream >> parser : " << setw(8) << tStream * 1000 << " ms  " << setw(8) << megabytes / tStream << " MB/s" << endl;
+        cout << "  buffered scanner   : " << setw(8) << tFast * 1000 << " ms  " << setw(8) << megabytes / tFast << " MB/s" << endl;
+        cout << "  chunked (" << setw(2) << threads << " thr)   : " << setw(8) << tChunked * 1000 << " ms  " << setw(8) << megabytes / tChunked << " MB/s" << endl;
+        cout << "  speedup            : " << setw(8) << tStream / min(tFast, tChunked) << "x" << endl;
+
+        bool match = samePixels(reference.get(), fast.get()) && samePixels(reference.get(), chunked.get());
+        cout << "  pixel data         : " << (match ? "identical" : "MISMATCH") << endl;
+        return match ? 0 : 1;
+    }
+}
+
+// ============================================================
+// MODULE 12: TILED EXECUTION (Bounded Memory for Huge Scans)
+// ============================================================
+// Satellite and microscopy scans do not fit in memory. The tiled executor computes
+// one output tile at a time from its input tile plus a halo of haloRadius() pixels
+// on each side. Pixels within the halo of a tile edge see padding instead of real
+// neighbours, so they are thrown away; every kept pixel equals the whole-frame result.
+// Memory: one tile (+ halo) per ping-pong buffer, plus one strip of tile rows when
+// the output format is row-based.
+namespace Tiled {
+    // Converts a PPM/PGM into the tiled container, one strip of tile rows at a time
+    int convert(const string& inputFile, const string& outputFile, int tileSize) {
+        RowReader reader;
+        if (!reader.open(inputFile)) return 1;
+        int w = reader.getWidth(), h = reader.getHeight();
+
+        TiledImageWriter writer;
+        if (!writer.open(outputFile, w, h, tileSize)) return 1;
+
+        Image strip(w, tileSize);
+        for (int y = 0; y < h; y += tileSize) {
+            int rows = min(tileSize, h - y);
+            for (int r = 0; r < rows; r++) reader.readRow(strip.getData() + (size_t)r * w);
+            for (int x = 0; x < w; x += tileSize) {
+                writer.writeTile(strip.getData() + x, w, min(tileSize, w - x), rows);
+            }
+        }
+        if (!writer.close()) {
+            cerr << "[ERROR] Write failed: " << outputFile << endl;
+            return 1;
+        }
+        cout << "\n[SUCCESS] Tiled file written: " << outputFile << " (" << tileSize << "x" << tileSize << " tiles)" << endl;
+        return 0;
+    }
+
+    // Runs the default chain over a tiled file. Output: .fpt (tile by tile),
+    // or .ppm/.pgm written row by row from a strip of finished tiles.
+    int run(const string& inputFile, const string& outputFile) {
+        string extension = filesystem::path(outputFile).extension().string();
+        if (extension == ".qoi") {
+            cerr << "[ERROR] Tiled execution cannot write QOI (needs the whole frame); use .fpt, .ppm or .pgm" << endl;
+            return 1;
+        }
+
+        TiledImageReader reader;
+        if (!reader.open(inputFile)) return 1;
+        int w = reader.getWidth(), h = reader.getHeight(), tileSize = reader.getTileSize();
+
+        Pipeline pipe;
+        addDefaultStages(pipe);
+        DumpPolicy noDumps; // Per-tile debug frames would be meaningless
+        noDumps.configure("off");
+        pipe.setDumpPolicy(&noDumps);
+        int halo = pipe.haloRadius();
+
+        bool tiledOutput = (extension == ".fpt");
+        TiledImageWriter tileWriter;
+        RowWriter rowWriter;
+        if (tiledOutput ? !tileWriter.open(outputFile, w, h, tileSize) : !rowWriter.open(outputFile, w, h, IOHandler::binaryPPM)) return 1;
+        unique_ptr<Image> strip = tiledOutput ? nullptr : make_unique<Image>(w, tileSize); // Finished rows of one tile row
+
+        bool wasQuiet = Logger::quiet;
+        Logger::quiet = true; // Stage logs for every tile would flood the console
+        long long tiles = 0;
+        bool ok = true;
+        for (int y = 0; y < h && ok; y += tileSize) {
+            int tileH = min(tileSize, h - y);
+            for (int x = 0; x < w; x += tileSize) {
+                int tileW = min(tileSize, w - x);
+
+                // Input region: the tile plus the halo, clipped to the image
+                int rx = max(0, x - halo), ry = max(0, y - halo);
+                int rw = min(w, x + tileW + halo) - rx, rh = min(h, y + tileH + halo) - ry;
+                if (!(ok = reader.readRegion(rx, ry, pipe.frameSlot(rw, rh)))) break;
+                pipe.execute();
+
+                const Pixel* core = pipe.getResult()->getData() + (size_t)(y - ry) * rw + (x - rx);
+                if (tiledOutput) {
+                    tileWriter.writeTile(core, rw, tileW, tileH);
+                } else {
+                    for (int r = 0; r < tileH; r++) {
+                        memcpy(strip->getData() + (size_t)r * w + x, core + (size_t)r * rw, (size_t)tileW * sizeof(Pixel));
+                    }
+                }
+                tiles++;
+            }
+            if (!tiledOutput && ok) {
+                for (int r = 0; r < tileH; r++) rowWriter.writeRow(strip->getData() + (size_t)r * w);
+            }
+        }
+        Logger::quiet = wasQuiet;
+        if (tiledOutput && !tileWriter.close()) ok = false;
+        if (!ok) {
+            cerr << "[ERROR] Tiled execution failed" << endl;
+            return 1;
+        }
+
+        cout << "[TILED]      : " << tiles << " tiles of " << tileSize << "x" << tileSize << " (halo " << halo << " px)" << endl;
+        FramePool::global().report(cout);
+        cout << "\n[SUCCESS] Tiled Execution Complete! Output: " << outputFile << endl;
+        return 0;
+    }
+}
+
+// ============================================================
+// MAIN APPLICATION
+// ============================================================
+
+// Streaming mode: the frame never resides in memory as a whole
+int runStreaming(const string& inputFile, const string& outputFile) {
+    RowReader reader;
+    if (!reader.open(inputFile)) return 1;
+
+    RowWriter writer;
+    if (!writer.open(outputFile, reader.getWidth(), reader.getHeight(), IOHandler::binaryPPM)) return 1;
+
+    StreamingPipeline pipe;
+    addDefaultStages(pipe);
+    if (!pipe.execute(reader, writer)) return 1;
+
+    cout << "\n[SUCCESS] Streaming Execution Complete! Output: " << outputFile << endl;
+    return 0;
+}
+
+// Video mode: Y4M frames stream through one pipeline whose buffers are reused for every frame
+int runVideo(const string& inputFile, const string& outputFile) {
+    Y4MReader reader;
+    if (!reader.open(inputFile)) return 1;
+
+    Y4MWriter writer;
+    if (!writer.open(outputFile, reader.getFormat())) return 1;
+
+    // The luma plane is already the Grayscale stage's output (Y*256 >> 8 == Y),
+    // so it is read straight into the pipeline's Gray8 buffer and the chain starts
+    // at the blur. The fused kernel does the same in one sweep (Gray8 input skips
+    // its grayscale step) without the intermediate blurred frame.
+    Pipeline pipe;
+    if (fuseDefaultStages) {
+        pipe.addStage(new FusedEdgeFilter());
+    } else {
+        pipe.addStage(new BlurFilter());
+        pipe.addStage(new SobelFilter());
+    }
+    const Y4MFormat& format = reader.getFormat();
+
+    bool wasQuiet = Logger::quiet;
+    Logger::quiet = true; // Per-frame stage logs would flood the console
+    auto t0 = chrono::steady_clock::now();
+    long long frames = 0;
+    while (reader.readFrame(pipe.graySlot(format.width, format.height))) {
+        pipe.execute();
+        writer.writeFrame(pipe.getGrayResult());
+        frames++;
+    }
+    pipe.flushDebugDumps();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    Logger::quiet = wasQuiet;
+
+    cout << fixed << setprecision(2) << right;
+    cout << "[VIDEO]      : " << frames << " frames in " << seconds << " s (" << (seconds > 0 ? frames / seconds : 0.0) << " frames/s)" << endl;
+    FramePool::global().report(cout);
+    cout << "\n[SUCCESS] Video Execution Complete! Output: " << outputFile << endl;
+    return 0;
+}
+
+// Pipe mode: concatenated P6/P5 frames from stdin to stdout, nothing touches the filesystem
+int runPipe() {
+    ios::sync_with_stdio(false); // Plain buffered streams; stdio is not used in this mode
+    cin.tie(nullptr);
+    Logger::stream = &cerr;
+    Logger::quiet = true;
+
+    DumpPolicy noDumps; // Per-frame debug files are never written here
+    noDumps.configure("off");
+
+    Pipeline pipe;
+    addDefaultStages(pipe);
+    pipe.setDumpPolicy(&noDumps);
+
+    PNMFrameReader reader(cin);
+    PNMFrameWriter writer(cout);
+    long long frames = 0;
+    int w, h;
+    bool gray;
+    bool ok = true;
+    while (reader.nextHeader(w, h, gray)) {
+        // Frames are read directly into the pipeline's input buffer
+        if (!(ok = reader.readPayload(pipe.frameSlot(w, h), gray))) break;
+        pipe.execute();
+        GrayImage* grayResult = pipe.getGrayResult();
+        if (gray && grayResult) writer.writeFrame(grayResult); // P5 straight from the Gray8 buffer
+        else writer.writeFrame(pipe.getResult(), gray);
+        frames++;
+    }
+    if (!cin.eof()) ok = false; // Stopped at a malformed header or truncated frame
+
+    cerr << "[PIPE]       : " << frames << " frames processed" << endl;
+    FramePool::global().report(cerr);
+    return ok ? 0 : 1;
+}
+
+// Rectangle in frame coordinates (--roi x,y,w,h)
+struct Region {
+    int x, y, w, h;
+};
+
+// ROI mode: only the listed regions are processed. Each one is read in place from the
+// input frame through a view, widened by haloRadius() pixels so the kept pixels equal
+// the whole-frame result. Pixels outside every region are black in the output.
+int runRegions(const Image* input, const vector<Region>& regions, const string& outputFile) {
+    Pipeline pipe;
+    addDefaultStages(pipe);
+    int halo = pipe.haloRadius();
+
+    int w = input->getWidth(), h = input->getHeight();
+    Image output(w, h);
+    memset(output.getData(), 0, (size_t)w * h * sizeof(Pixel));
+    ImageView frame(input), canvas(&output);
+
+    long long processed = 0;
+    for (size_t i = 0; i < regions.size(); i++) {
+        ImageView roi = frame.region(regions[i].x, regions[i].y, regions[i].w, regions[i].h);
+        if (roi.getWidth() == 0 || roi.getHeight() == 0) {
+            cerr << "[ERROR] ROI " << i + 1 << " lies outside the " << w << "x" << h << " frame" << endl;
+            return 1;
+        }
+        int x = max(regions[i].x, 0), y = max(regions[i].y, 0);
+
+        // Input region: the ROI plus the halo, clipped to the frame
+        int rx = max(0, x - halo), ry = max(0, y - halo);
+        int rw = min(w, x + roi.getWidth() + halo) - rx, rh = min(h, y + roi.getHeight() + halo) - ry;
+        pipe.setDebugPrefix("roi" + to_string(i + 1) + "_");
+        pipe.loadFrame(frame.region(rx, ry, rw, rh));
+        pipe.execute();
+
+        ImageView(pipe.getResult()).region(x - rx, y - ry, roi.getWidth(), roi.getHeight())
+            .copyTo(canvas.region(x, y, roi.getWidth(), roi.getHeight()));
+        processed += (long long)roi.getWidth() * roi.getHeight();
+    }
+    pipe.flushDebugDumps();
+    IOHandler::saveImage(&output, outputFile);
+
+    cout << fixed << setprecision(1) << right;
+    cout << "[ROI]        : " << regions.size() << " regions, " << processed << " of " << (long long)w * h
+         << " pixels (" << 100.0 * processed / ((double)w * h) << "%, halo " << halo << " px)" << endl;
+    FramePool::global().report(cout);
+    cout << "\n[SUCCESS] ROI Execution Complete! Output: " << outputFile << endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Command line options
+    //   --bench <file.ppm>   P3 loader benchmark
+    //   --dump <spec>        debug dump policy (see DumpPolicy), overrides FPGA_DUMP
+    //   --output <file>      final result file; format from extension (.ppm, .pgm, .qoi)
+    //   --binary             write a .ppm result as P6 instead of P3 text
+    //   --stream <file>      row-by-row streaming execution (O(width) memory)
+    //   --batch <dir|list>   headless multi-frame mode (outputs: <outdir>/<name>_out<ext of --output>)
+    //   --outdir <dir>       batch output directory (default: current directory)
+    //   --threads <N>        batch worker threads (default: CPU count)
+    //   --io <sync|uring>    batch file I/O backend (default: sync)
+    //   --y4m <file|->       Y4M video stream (file or stdin); result is a .y4m (final_output.y4m by default)
+    //   --pipe               concatenated P6/P5 frames from stdin to stdout (no files, no debug dumps)
+    //   --to-tiled <file>    convert a PPM/PGM into the tiled .fpt container (--tile-size N, default 256)
+    //   --tiled <file.fpt>   tile-by-tile execution with bounded memory; output .fpt, .ppm or .pgm
+    //   --layout <interleaved|planar>  frame layout inside the pipeline (default: interleaved RGB)
+    //   --border <zero|replicate|reflect>  edge padding of the 3x3 stages (default: zero; streaming mode is always zero)
+    //   --roi <x,y,w,h>      process only this region (repeatable); the rest of the output is black
+    //   --hugepages <off|transparent|explicit>  page backing of frames >= 2 MB (default: transparent)
+    //   --numa               node-local frame memory; batch workers are spread over the NUMA nodes
+    //   --stages <fused|separate>  default chain as one fused kernel (default) or as three stages
+    //                        (separate: per-stage debug dumps)
+    //   --cache-block <auto|KB|off>  run all stages tile by tile, each tile's working set within
+    //                        the given budget (auto: half the L2 cache)
+    string outputFile = "final_output.ppm";
+    string streamInput;
+    string videoInput;
+    bool pipeMode = false;
+    string tiledInput, convertInput;
+    int tileSize = TiledFormat::DEFAULT_TILE_SIZE;
+    string batchSource, outDir = ".";
+    unsigned threads = 0;
+    bool useUring = false;
+    vector<Region> regions;
+    HugePageMode hugePages = HugePageMode::Transparent;
+    bool numaLocal = false;
+    bool dumpConfigured = getenv("FPGA_DUMP") != nullptr;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bench" && i + 1 < argc) {
+            return Benchmark::runLoaderBenchmark(argv[++i]);
+        } else if (arg == "--dump" && i + 1 < argc) {
+            if (!DumpPolicy::global().configure(argv[++i])) {
+                cerr << "[ERROR] Invalid dump policy: " << argv[i] << endl;
+                return 1;
+            }
+            dumpConfigured = true;
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputFile = argv[++i];
+        } else if (arg == "--stream" && i + 1 < argc) {
+            streamInput = argv[++i];
+        } else if (arg == "--to-tiled" && i + 1 < argc) {
+            convertInput = argv[++i];
+        } else if (arg == "--tiled" && i + 1 < argc) {
+            tiledInput = argv[++i];
+        } else if (arg == "--tile-size" && i + 1 < argc) {
+            tileSize = atoi(argv[++i]);
+            if (tileSize < 1 || tileSize > 65536) {
+                cerr << "[ERROR] Invalid tile size: " << argv[i] << endl;
+                return 1;
+            }
+        } else if (arg == "--layout" && i + 1 < argc) {
+            string layout = argv[++i];
+            if (layout != "interleaved" && layout != "planar") {
+                cerr << "[ERROR] Unknown layout: " << layout << endl;
+                return 1;
+            }
+            Pipeline::defaultLayout = (layout == "planar") ? FrameLayout::Planar : FrameLayout::Interleaved;
+        } else if (arg == "--border" && i + 1 < argc) {
+            string mode = argv[++i];
+            if (mode == "zero") Pipeline::defaultBorder = BorderMode::Zero;
+            else if (mode == "replicate") Pipeline::defaultBorder = BorderMode::Replicate;
+            else if (mode == "reflect") Pipeline::defaultBorder = BorderMode::Reflect;
+            else {
+                cerr << "[ERROR] Unknown border mode: " << mode << endl;
+                return 1;
+            }
+        } else if (arg == "--roi" && i + 1 < argc) {
+            Region r;
+            char end;
+            if (sscanf(argv[++i], "%d,%d,%d,%d%c", &r.x, &r.y, &r.w, &r.h, &end) != 4 || r.w < 1 || r.h < 1) {
+                cerr << "[ERROR] Invalid ROI (expected x,y,w,h): " << argv[i] << endl;
+                return 1;
+            }
+            regions.push_back(r);
+        } else if (arg == "--hugepages" && i + 1 < argc) {
+            string mode = argv[++i];
+            if (mode == "off") hugePages = HugePageMode::Off;
+            else if (mode == "transparent") hugePages = HugePageMode::Transparent;
+            else if (mode == "explicit") hugePages = HugePageMode::Explicit;
+            else {
+                cerr << "[ERROR] Unknown huge page mode: " << mode << endl;
+                return 1;
+            }
+        } else if (arg == "--stages" && i + 1 < argc) {
+            string chain = argv[++i];
+            if (chain != "fused" && chain != "separate") {
+                cerr << "[ERROR] Unknown stage chain: " << chain << endl;
+                return 1;
+            }
+            fuseDefaultStages = (chain == "fused");
+        } else if (arg == "--cache-block" && i + 1 < argc) {
+            string size = argv[++i];
+            long kb = (size == "auto") ? (long)(Pipeline::l2Budget() / 1024) : (size == "off") ? 0 : atol(size.c_str());
+            if (size != "off" && (kb < 1 || kb > (1l << 30))) {
+                cerr << "[ERROR] Invalid cache block budget: " << size << endl;
+                return 1;
+            }
+            Pipeline::defaultBlockBytes = (size_t)kb * 1024;
+        } else if (arg == "--numa") {
+            numaLocal = true;
+        } else if (arg == "--pipe") {
+            pipeMode = true;
+        } else if (arg == "--y4m" && i + 1 < argc) {
+            videoInput = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchSource = argv[++i];
+        } else if (arg == "--outdir" && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = (unsigned)max(0, atoi(argv[++i]));
+        } else if (arg == "--io" && i + 1 < argc) {
+            string backend = argv[++i];
+            if (backend != "sync" && backend != "uring") {
+                cerr << "[ERROR] Unknown I/O backend: " << backend << endl;
+                return 1;
+            }
+            useUring = (backend == "uring");
+        } else if (arg == "--binary") {
+            IOHandler::binaryPPM = true;
+        } else {
+            cerr << "[ERROR] Unknown option: " << arg << endl;
+            cerr << "Usage: " << argv[0] << " [--dump off|all|every:N|changed[,binary|,qoi]]"
+                 << " [--output <file.ppm|.pgm|.qoi|.y4m>] [--binary] [--stream <file>] [--y4m <file|->] [--pipe]"
+                 << " [--to-tiled <file> [--tile-size N]] [--tiled <file.fpt>] [--layout interleaved|planar]"
+                 << " [--border zero|replicate|reflect] [--roi x,y,w,h ...] [--hugepages off|transparent|explicit] [--numa]"
+                 << " [--stages fused|separate] [--cache-block auto|KB|off]"
+                 << " [--batch <dir|list> [--outdir <dir>] [--threads N] [--io sync|uring]] [--bench <file.ppm>]" << endl;
+            return 1;
+        }
+    }
+
+    FramePool::global().configure(hugePages, numaLocal);
+
+    if (!streamInput.empty()) {
+        return runStreaming(streamInput, outputFile);
+    }
+
+    if (pipeMode) {
+        return runPipe();
+    }
+
+    if (!convertInput.empty()) {
+        if (filesystem::path(outputFile).extension() != ".fpt") {
+            outputFile = filesystem::path(convertInput).filename().replace_extension(".fpt").string();
+        }
+        return Tiled::convert(convertInput, outputFile, tileSize);
+    }
+
+    if (!tiledInput.empty()) {
+        return Tiled::run(tiledInput, outputFile);
+    }
+
+    if (!videoInput.empty()) {
+        // Debug dumps would be rewritten for every frame; only on explicit request
+        if (!dumpConfigured) DumpPolicy::global().configure("off");
+        if (filesystem::path(outputFile).extension() != ".y4m") outputFile = "final_output.y4m";
+        return runVideo(videoInput, outputFile);
+    }
+
+    if (!batchSource.empty()) {
+        // Production batches skip debug dumps unless they were explicitly requested
+        if (!dumpConfigured) DumpPolicy::global().configure("off");
+        return Batch::run(batchSource, outDir, filesystem::path(outputFile).extension().string(), threads, useUring);
+    }
+
+    cout << "\n==============================================" << endl;
+    cout << "   FPGA IMAGE PROCESSING SIMULATOR (CLI)" << endl;
+    cout << "==============================================\n" << endl;
+
+    string filename;
+    unique_ptr<Image> inputImg;
+
+    // User Input Loop
+    while (true) {
+        cout << "Enter input image filename (e.g., photo_ascii.ppm): ";
+        cin >> filename;
+
+        inputImg = IOHandler::mapPPM(filename);
+        if (inputImg) break;
+        
+        cout << "[ERROR] File not found or invalid format!" << endl;
+        cout << "Hint: Ensure the file is PPM (P3/P6), PGM (P5) or QOI format." << endl;
+        cout << "Try again? (y/n): ";
+        char choice; cin >> choice;
+        if (choice == 'n') return 0;
+    }
+
+    if (!regions.empty()) {
+        return runRegions(inputImg.get(), regions, outputFile);
+    }
+
+    // Pipeline Setup (the frame is handed over: no copy, freed with the pipeline)
+    Pipeline fpgaPipe(move(*inputImg));
+    
+    // Add Processing Modules
+    addDefaultStages(fpgaPipe);
+
+    // Run Simulation
+    fpgaPipe.execute();
+
+    // Save Final Result
+    fpgaPipe.saveResult(outputFile);
+    FramePool::global().report(cout);
     
     cout << "\n[SUCCESS] Pipeline Execution Complete!" << endl;
-    cout << "Check your folder for 'final_output.ppm' and debug files." << endl;
+    cout << "Check your folder for '" << outputFile << "' and debug files." << endl;
 
     return 0;
 }